@@ -1,16 +1,61 @@
 /** @file   circular_buffer.c
- *  @brief  An implementation of a circular buffer used to store 
- *          integers in C.
+ *  @brief  An implementation of a circular buffer used to store
+ *          integers in C. Also contains a lock-free single-producer/
+ *          single-consumer (SPSC) variant for handing values from
+ *          one thread to another and a bounded multi-producer/
+ *          multi-consumer (MPMC) variant for sharing one buffer
+ *          between many threads.
+ *          The blocking buffer wraps the MPMC buffer with push/pop
+ *          calls that wait (with a timeout) instead of failing, sleeping
+ *          on a futex or an eventfd that can be added to an epoll loop.
+ *          The window buffer keeps the sum, min and max of the values
+ *          it holds up to date as values enter and leave, so they can
+ *          be queried in O(1).
+ *          The record buffer holds fixed-size records of any type,
+ *          is sized at runtime and overwrites the oldest record when
+ *          full (e.g. to keep the last N events).
+ *          The persistent buffer keeps its records and indexes in a
+ *          memory-mapped file so a restarted process carries on from
+ *          the last committed read position.
+ *          The mirrored byte buffer maps the same memory twice back to
+ *          back so that data never has to be split at the wrap point
+ *          (Linux only, uses memfd_create()).
+ *          Compile with -DBENCHMARK to run the benchmarks.
  *  @author Mustafa Siddiqui
  *  @date   01/19/2020
  */
 
+#define _GNU_SOURCE                 // memfd_create(), syscall()
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>                 // memcpy()
+#include <stdatomic.h>
+#include <limits.h>                 // INT_MAX
+#include <time.h>                   // clock_gettime()
+#include <poll.h>
+#include <fcntl.h>                  // open()
+#include <sys/stat.h>               // fstat()
+#include <sys/mman.h>               // mmap(), memfd_create()
+#include <sys/eventfd.h>
+#include <sys/syscall.h>            // SYS_futex
+#include <linux/futex.h>
+#include <unistd.h>                 // ftruncate(), sysconf(), syscall()
+
+#ifdef BENCHMARK
+#include <pthread.h>
+#include <sched.h>                  // sched_yield()
+#endif
 
 #define MAX_BUFFER_LENGTH (10)
 
+/* Size of a cache line. Indexes owned by different threads are kept
+   this far apart so that they don't share a cache line. */
+#define CACHE_LINE_SIZE (64)
+
 /* Struct to hold circular buffer */
 struct circBuff {
     int length;
@@ -19,6 +64,174 @@ struct circBuff {
     int* values;
 } typedef circBuff;
 
+/*
+    Struct to hold a lock-free single-producer/single-consumer circular
+    buffer. The read and write indexes keep counting up and are masked
+    with (capacity - 1) on access, so the capacity is always a power of
+    two and the number of stored values is (writeIndex - readIndex).
+    Each thread also keeps a cached copy of the other thread's index so
+    it only reads the shared one when the cached copy says full/empty.
+*/
+struct spscCircBuff {
+    // written by the producer only
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t writeIndex;
+    size_t cachedReadIndex;
+
+    // written by the consumer only
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t readIndex;
+    size_t cachedWriteIndex;
+
+    // read-only after creation
+    _Alignas(CACHE_LINE_SIZE) size_t mask;
+    int* values;
+} typedef spscCircBuff;
+
+/* Slot of a MPMC buffer. */
+struct mpmcSlot {
+    atomic_size_t sequence;
+    int value;
+} typedef mpmcSlot;
+
+/*
+    Struct to hold a bounded lock-free multi-producer/multi-consumer
+    circular buffer. Every slot carries a sequence number that says
+    whose turn it is:
+    -   sequence == index       slot is free for the producer at 'index'
+    -   sequence == index + 1   slot holds a value for the consumer at 'index'
+    A producer or consumer claims its index with a single CAS and then
+    only touches its own slot, so threads never wait on each other.
+*/
+struct mpmcCircBuff {
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t writeIndex;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t readIndex;
+
+    // read-only after creation
+    _Alignas(CACHE_LINE_SIZE) size_t mask;
+    mpmcSlot* slots;
+} typedef mpmcCircBuff;
+
+/* Bounds for the number of tries a blocking call spins for before it
+   goes to sleep. The actual number adapts to how often spinning works. */
+#define MIN_SPIN_COUNT (16)
+#define MAX_SPIN_COUNT (4096)
+
+/*
+    Struct to hold a blocking circular buffer built on the MPMC buffer.
+    Threads that have to wait first spin for a while and then sleep on
+    a futex word ('notEmpty'/'notFull'), or on 'eventFd' for consumers
+    if it was created with one. Each side counts its sleeping threads
+    so that the other side only makes a wakeup system call when someone
+    is actually asleep.
+*/
+struct blockingCircBuff {
+    mpmcCircBuff* ring;
+
+    // bumped on every wakeup so that sleepers notice the change
+    _Alignas(CACHE_LINE_SIZE) atomic_int notEmpty;
+    atomic_int emptyWaiters;
+
+    _Alignas(CACHE_LINE_SIZE) atomic_int notFull;
+    atomic_int fullWaiters;
+
+    // shared by both sides, only a hint so races on it are harmless
+    _Alignas(CACHE_LINE_SIZE) atomic_int spinCount;
+    int eventFd;
+} typedef blockingCircBuff;
+
+/*
+    Deque of value sequence numbers used by the window buffer. Entries
+    are in [head, tail), both of which keep counting up and are taken
+    modulo the window capacity on access.
+*/
+struct monotonicDeque {
+    size_t head;
+    size_t tail;
+    size_t* sequences;
+} typedef monotonicDeque;
+
+/*
+    Struct to hold a sliding window of integers. Values are numbered in
+    the order they are written ('readSequence' is the oldest value and
+    'writeSequence' the next one). Alongside the values it keeps:
+    -   the sum of all values in the window
+    -   'minDeque': values that could still become the minimum, i.e.
+        each one smaller than every value written after it, oldest first
+    -   'maxDeque': the same for the maximum
+    so the front of each deque is the current min/max.
+*/
+struct windowCircBuff {
+    size_t length;
+    size_t capacity;
+    size_t readSequence;
+    size_t writeSequence;
+    long long sum;
+    int* values;
+    monotonicDeque minDeque;
+    monotonicDeque maxDeque;
+} typedef windowCircBuff;
+
+/*
+    Struct to hold a circular buffer of fixed-size records. When the
+    buffer is full, writing a record evicts the oldest one and counts
+    it in 'dropped'.
+*/
+struct recordCircBuff {
+    size_t length;
+    size_t readIndex;
+    size_t writeIndex;
+    size_t capacity;
+    size_t recordSize;
+    unsigned long long dropped;
+    unsigned char* values;
+} typedef recordCircBuff;
+
+/* Identifies a persistent buffer file ("CIRCBUF1"). */
+#define PERSISTENT_MAGIC (0x3146554243524943ULL)
+
+/*
+    Header at the start of a persistent buffer file. Indexes keep
+    counting up and are taken modulo 'capacity' on access.
+*/
+struct persistentHeader {
+    uint64_t magic;
+    uint64_t capacity;
+    uint64_t recordSize;
+    _Atomic uint64_t readIndex;
+    _Atomic uint64_t writeIndex;
+} typedef persistentHeader;
+
+/*
+    Struct to hold a circular buffer of fixed-size records backed by a
+    memory-mapped file. Every slot starts with a checksum of its record
+    mixed with the record's index, which lets recovery throw away a
+    record that was only partly written before a crash.
+    'readCursor' is where popping has got to; it only becomes the
+    header's 'readIndex' (the restart point) when the read is committed.
+*/
+struct persistentCircBuff {
+    persistentHeader* header;
+    unsigned char* values;
+    size_t slotSize;
+    size_t mappedSize;
+    uint64_t readCursor;
+    int fd;
+} typedef persistentCircBuff;
+
+/*
+    Struct to hold a mirrored circular buffer of bytes. 'values' points
+    to (2 * capacity) bytes of address space where the second half maps
+    the same memory as the first, so values[i] and values[i + capacity]
+    are the same byte. Any stored or free region starting at an index
+    below 'capacity' is therefore contiguous in memory.
+*/
+struct mirrorCircBuff {
+    size_t length;
+    size_t readIndex;
+    size_t writeIndex;
+    size_t capacity;
+    unsigned char* values;
+} typedef mirrorCircBuff;
+
 /*
 __________________________________________________________________
 
@@ -33,7 +246,7 @@ __________________________________________________________________
 void initializeBuff(circBuff* buffer, int length);
 
 /*
-    Write integer value at the next available index of the 
+    Write integer value at the next available index of the
     circular buffer. If buffer is full, value will not be
     written to the buffer.
 */
@@ -46,12 +259,283 @@ void writeValue(circBuff* buffer, int value);
 */
 int popValue(circBuff* buffer);
 
+/*
+    Write up to 'n' values from 'src' to the buffer. Values are copied
+    in at most two blocks (before and after the end of the array) and
+    the indexes are updated once. Values that don't fit are not written.
+    Returns the number of values written.
+*/
+int writeValues(circBuff* buffer, const int* src, int n);
+
+/*
+    Pop up to 'n' of the oldest values from the buffer into 'dst'.
+    Values are copied out in at most two blocks and the indexes are
+    updated once. Unlike popValue(), slots are not reset to 0.
+    Returns the number of values popped.
+*/
+int popValues(circBuff* buffer, int* dst, int n);
+
 /*
     Free the allocated memory for the circular buffer. Frees
     the integer array and the buffer itself.
 */
 void freeBuffer(circBuff* buffer);
 
+/*
+    Allocate and initialize a SPSC buffer. The capacity is rounded up
+    to the next power of two.
+*/
+spscCircBuff* createSpscBuff(size_t capacity);
+
+/*
+    Write value to the SPSC buffer. Must only be called from the
+    producer thread. Returns 1 if the value was written and 0 if the
+    buffer is full.
+*/
+int spscWriteValue(spscCircBuff* buffer, int value);
+
+/*
+    Read the oldest value from the SPSC buffer into 'value'. Must only
+    be called from the consumer thread. Returns 1 if a value was read
+    and 0 if the buffer is empty.
+*/
+int spscPopValue(spscCircBuff* buffer, int* value);
+
+/*
+    Free the allocated memory for the SPSC buffer. Neither thread may
+    use the buffer after this is called.
+*/
+void freeSpscBuffer(spscCircBuff* buffer);
+
+/*
+    Allocate and initialize a MPMC buffer. The capacity is rounded up
+    to the next power of two.
+*/
+mpmcCircBuff* createMpmcBuff(size_t capacity);
+
+/*
+    Write value to the MPMC buffer. Safe to call from any number of
+    threads. Returns 1 if the value was written and 0 if the buffer
+    is full.
+*/
+int mpmcTryWriteValue(mpmcCircBuff* buffer, int value);
+
+/*
+    Read the oldest value from the MPMC buffer into 'value'. Safe to
+    call from any number of threads. Returns 1 if a value was read and
+    0 if the buffer is empty.
+*/
+int mpmcTryPopValue(mpmcCircBuff* buffer, int* value);
+
+/*
+    Free the allocated memory for the MPMC buffer. No thread may use
+    the buffer after this is called.
+*/
+void freeMpmcBuffer(mpmcCircBuff* buffer);
+
+/*
+    Allocate a blocking buffer. If 'useEventFd' is non-zero, consumers
+    sleep on an eventfd (see blockingBuffFd()) instead of a futex.
+    Returns NULL if the eventfd could not be created.
+*/
+blockingCircBuff* createBlockingBuff(size_t capacity, int useEventFd);
+
+/*
+    Write value to the blocking buffer, waiting for space if it is full.
+    'timeoutNs' is the longest time to wait in nanoseconds; a negative
+    value waits forever and 0 doesn't wait at all.
+    Returns 1 if the value was written and 0 on timeout.
+*/
+int pushWait(blockingCircBuff* buffer, int value, long long timeoutNs);
+
+/*
+    Read the oldest value into 'value', waiting for one if the buffer is
+    empty. 'timeoutNs' works as for pushWait().
+    Returns 1 if a value was read and 0 on timeout.
+*/
+int popWait(blockingCircBuff* buffer, int* value, long long timeoutNs);
+
+/*
+    Return the eventfd that becomes readable when values are written to
+    an empty buffer, or -1 if the buffer wasn't created with one.
+    To wait in an epoll loop, call parkConsumer() before epoll_wait(),
+    unparkConsumer() after it and then pop with popWait(buffer, &v, 0).
+*/
+int blockingBuffFd(blockingCircBuff* buffer);
+
+/*
+    Register the caller as a sleeping consumer so producers send a
+    wakeup. Returns 0 (without registering) if the buffer isn't empty,
+    in which case the caller should pop instead of sleeping.
+*/
+int parkConsumer(blockingCircBuff* buffer);
+
+/*
+    Undo parkConsumer() after waking up and clear the eventfd. If other
+    consumers are still parked and values are left, the eventfd is made
+    readable again for them.
+*/
+void unparkConsumer(blockingCircBuff* buffer);
+
+/*
+    Free the allocated memory for the blocking buffer. No thread may
+    use or wait on the buffer after this is called.
+*/
+void freeBlockingBuffer(blockingCircBuff* buffer);
+
+/*
+    Allocate a window buffer that holds up to 'capacity' values.
+*/
+windowCircBuff* createWindowBuff(size_t capacity);
+
+/*
+    Add value to the window. If the window is full, the oldest value
+    slides out of it first. O(1) amortized.
+*/
+void windowWriteValue(windowCircBuff* buffer, int value);
+
+/*
+    Remove the oldest value from the window into 'value'. O(1).
+    Returns 1 if a value was popped and 0 if the window is empty.
+*/
+int windowPopValue(windowCircBuff* buffer, int* value);
+
+/*
+    Return the sum of the values in the window. O(1).
+*/
+long long windowSum(windowCircBuff* buffer);
+
+/*
+    Return the smallest/largest value in the window. O(1). The window
+    must not be empty.
+*/
+int windowMin(windowCircBuff* buffer);
+int windowMax(windowCircBuff* buffer);
+
+/*
+    Free the allocated memory for the window buffer.
+*/
+void freeWindowBuffer(windowCircBuff* buffer);
+
+/*
+    Allocate a record buffer that holds up to 'capacity' records of
+    'recordSize' bytes each.
+*/
+recordCircBuff* createRecordBuff(size_t capacity, size_t recordSize);
+
+/*
+    Copy 'record' into the buffer. If the buffer is full, the oldest
+    record is overwritten and 'dropped' is incremented. Never fails and
+    never prints.
+*/
+void writeRecord(recordCircBuff* buffer, const void* record);
+
+/*
+    Copy the oldest record into 'record' and remove it from the buffer.
+    Returns 1 if a record was popped and 0 if the buffer is empty.
+*/
+int popRecord(recordCircBuff* buffer, void* record);
+
+/*
+    Free the allocated memory for the record buffer.
+*/
+void freeRecordBuffer(recordCircBuff* buffer);
+
+/*
+    Open the persistent buffer stored in the file at 'path', creating it
+    if it doesn't exist. An existing file must have been created with the
+    same capacity and record size. Records that were not completely
+    written before a crash are discarded.
+    Returns NULL if the file can't be opened, mapped or doesn't match.
+*/
+persistentCircBuff* openPersistentBuff(const char* path, size_t capacity, size_t recordSize);
+
+/*
+    Copy 'record' into the buffer. The record becomes visible (and
+    survives a crash of the process) in one step once it is complete.
+    Returns 1 if the record was written and 0 if the buffer is full.
+*/
+int persistentWriteRecord(persistentCircBuff* buffer, const void* record);
+
+/*
+    Copy the next record into 'record'. The record stays in the file
+    until persistentCommitRead() is called, so a process that restarts
+    before committing gets it again.
+    Returns 1 if a record was popped and 0 if there are none left.
+*/
+int persistentPopRecord(persistentCircBuff* buffer, void* record);
+
+/*
+    Mark every record popped so far as done, freeing up their space and
+    moving the position a restarted process resumes from.
+*/
+void persistentCommitRead(persistentCircBuff* buffer);
+
+/*
+    Flush records and indexes to disk so that they also survive a power
+    failure. Returns 0 on success and -1 on failure.
+*/
+int persistentSync(persistentCircBuff* buffer);
+
+/*
+    Sync and unmap the persistent buffer, then free the buffer itself.
+    Uncommitted reads are not committed.
+*/
+void closePersistentBuffer(persistentCircBuff* buffer);
+
+/*
+    Allocate a mirrored buffer. The capacity is rounded up to a multiple
+    of the page size. Returns NULL if the memory could not be mapped.
+*/
+mirrorCircBuff* createMirrorBuff(size_t capacity);
+
+/*
+    Return a pointer to the oldest stored byte and set 'available' to
+    the number of stored bytes, all of which can be read from the
+    returned pointer without wrapping. Nothing is removed from the
+    buffer until mirrorCommitRead() is called.
+*/
+unsigned char* mirrorPeekRead(mirrorCircBuff* buffer, size_t* available);
+
+/*
+    Remove 'count' bytes, previously returned by mirrorPeekRead(), from
+    the buffer.
+*/
+void mirrorCommitRead(mirrorCircBuff* buffer, size_t count);
+
+/*
+    Return a pointer to the first free byte and set 'available' to the
+    number of free bytes, all of which can be written from the returned
+    pointer without wrapping. Nothing is added to the buffer until
+    mirrorCommitWrite() is called.
+*/
+unsigned char* mirrorPeekWrite(mirrorCircBuff* buffer, size_t* available);
+
+/*
+    Add 'count' bytes, written to the pointer returned by
+    mirrorPeekWrite(), to the buffer.
+*/
+void mirrorCommitWrite(mirrorCircBuff* buffer, size_t count);
+
+/*
+    Unmap the memory for the mirrored buffer and free the buffer itself.
+*/
+void freeMirrorBuffer(mirrorCircBuff* buffer);
+
+#ifdef BENCHMARK
+/*
+    Two-thread throughput and round trip latency of the SPSC buffer
+    compared with a circBuff wrapped in a mutex.
+*/
+void benchmarkSpsc(void);
+
+/*
+    Throughput of the MPMC buffer with 1, 2, 4, 8 and 16 threads each
+    pushing and popping.
+*/
+void benchmarkMpmc(void);
+#endif
+
 /*
 __________________________________________________________________
 
@@ -77,9 +561,169 @@ int main(void) {
         printf("%d\n", popValue(buffer));
     }
 
+    // move values in batches, wrapping around the end of the array
+    int batch[MAX_BUFFER_LENGTH];
+    for (int i = 0; i < MAX_BUFFER_LENGTH; i++) {
+        batch[i] = (i + 1) * 10;
+    }
+    printf("Wrote %d values.\n", writeValues(buffer, batch, 6));
+    printf("Popped %d values.\n", popValues(buffer, batch, 4));
+    printf("Wrote %d values.\n", writeValues(buffer, batch, MAX_BUFFER_LENGTH));
+    int popped = popValues(buffer, batch, MAX_BUFFER_LENGTH);
+    for (int i = 0; i < popped; i++) {
+        printf("%d ", batch[i]);
+    }
+    printf("\n");
+
     // free allocated memory
     freeBuffer(buffer);
 
+    // same thing with the SPSC buffer, full/empty is reported through
+    // the return value
+    spscCircBuff* spsc = createSpscBuff(MAX_BUFFER_LENGTH);
+    for (int i = 0; i < 20; i++) {
+        if (!spscWriteValue(spsc, (i + 1))) {
+            printf("SPSC buffer full after %d values.\n", i);
+            break;
+        }
+    }
+    int value;
+    while (spscPopValue(spsc, &value)) {
+        printf("%d ", value);
+    }
+    printf("\n");
+    freeSpscBuffer(spsc);
+
+    // and with the MPMC buffer
+    mpmcCircBuff* mpmc = createMpmcBuff(MAX_BUFFER_LENGTH);
+    for (int i = 0; i < 20; i++) {
+        if (!mpmcTryWriteValue(mpmc, (i + 1))) {
+            printf("MPMC buffer full after %d values.\n", i);
+            break;
+        }
+    }
+    while (mpmcTryPopValue(mpmc, &value)) {
+        printf("%d ", value);
+    }
+    printf("\n");
+    freeMpmcBuffer(mpmc);
+
+    // waiting on an empty blocking buffer times out, then values go
+    // through as usual
+    blockingCircBuff* blocking = createBlockingBuff(4, 1);
+    if (blocking != NULL) {
+        printf("popWait on empty buffer: %d\n", popWait(blocking, &value, 10000000));
+        for (int i = 0; i < 4; i++) {
+            pushWait(blocking, (i + 1), -1);
+        }
+        printf("pushWait on full buffer: %d\n", pushWait(blocking, 5, 10000000));
+        while (popWait(blocking, &value, 0)) {
+            printf("%d ", value);
+        }
+        printf("\n");
+        freeBlockingBuffer(blocking);
+    }
+
+    // two consumers parked on the eventfd (as in an epoll loop) and two
+    // producers writing a value each: once the first consumer woke up
+    // and took a value, the eventfd must still wake the second one
+    blocking = createBlockingBuff(4, 1);
+    if (blocking != NULL) {
+        parkConsumer(blocking);
+        parkConsumer(blocking);
+        pushWait(blocking, 1, 0);
+        pushWait(blocking, 2, 0);
+
+        unparkConsumer(blocking);
+        popWait(blocking, &value, 0);
+
+        struct pollfd pfd = { .fd = blockingBuffFd(blocking), .events = POLLIN };
+        int woken = poll(&pfd, 1, 0);
+        unparkConsumer(blocking);
+        int popped = popWait(blocking, &value, 0);
+        printf("Second consumer woken: %d, popped %d: %d\n", woken, value, popped);
+        freeBlockingBuffer(blocking);
+    }
+
+    // statistics of the last 4 values
+    int samples[] = { 5, 1, 4, 8, 2, 7, 3, 6 };
+    windowCircBuff* window = createWindowBuff(4);
+    for (int i = 0; i < 8; i++) {
+        windowWriteValue(window, samples[i]);
+        printf("%d: sum %lld min %d max %d\n", samples[i], windowSum(window),
+               windowMin(window), windowMax(window));
+    }
+    freeWindowBuffer(window);
+
+    // keep the last 4 of 10 events
+    struct event {
+        int id;
+        double timestamp;
+    } event;
+    recordCircBuff* recorder = createRecordBuff(4, sizeof(event));
+    for (int i = 0; i < 10; i++) {
+        event.id = i;
+        event.timestamp = i * 0.5;
+        writeRecord(recorder, &event);
+    }
+    printf("Dropped %llu events, kept:", recorder->dropped);
+    while (popRecord(recorder, &event)) {
+        printf(" %d@%.1f", event.id, event.timestamp);
+    }
+    printf("\n");
+    freeRecordBuffer(recorder);
+
+    // records and committed reads survive closing and reopening
+    const char* path = "circular_buffer.dat";
+    persistentCircBuff* persistent = openPersistentBuff(path, 8, sizeof(int));
+    if (persistent != NULL) {
+        for (int i = 0; i < 5; i++) {
+            value = (i + 1) * 100;
+            persistentWriteRecord(persistent, &value);
+        }
+        persistentPopRecord(persistent, &value);
+        persistentPopRecord(persistent, &value);
+        persistentCommitRead(persistent);
+        persistentPopRecord(persistent, &value);
+        closePersistentBuffer(persistent);
+
+        persistent = openPersistentBuff(path, 8, sizeof(int));
+        printf("Resumed with:");
+        while (persistentPopRecord(persistent, &value)) {
+            printf(" %d", value);
+        }
+        printf("\n");
+        closePersistentBuffer(persistent);
+        unlink(path);
+    }
+
+    // write a message across the end of a mirrored buffer and read it
+    // back through a single pointer
+    mirrorCircBuff* mirror = createMirrorBuff(1);
+    if (mirror != NULL) {
+        size_t available;
+        mirrorPeekWrite(mirror, &available);
+        mirrorCommitWrite(mirror, available - 4);
+        mirrorPeekRead(mirror, &available);
+        mirrorCommitRead(mirror, available);
+
+        const char message[] = "wrapped message";
+        memcpy(mirrorPeekWrite(mirror, &available), message, sizeof(message));
+        mirrorCommitWrite(mirror, sizeof(message));
+
+        unsigned char* data = mirrorPeekRead(mirror, &available);
+        printf("%s (%zu bytes, starts at index %zu of %zu)\n", (char*) data,
+               available, mirror->readIndex, mirror->capacity);
+        mirrorCommitRead(mirror, available);
+
+        freeMirrorBuffer(mirror);
+    }
+
+    #ifdef BENCHMARK
+        benchmarkSpsc();
+        benchmarkMpmc();
+    #endif
+
     return 0;
 }
 
@@ -142,12 +786,1217 @@ int popValue(circBuff* buffer) {
     buffer->length--;
     buffer->readIndex++;
 
+    // wrap around if end of array reached
+    if (buffer->readIndex == MAX_BUFFER_LENGTH) {
+        buffer->readIndex = 0;
+    }
+
     return temp;
 }
 
+/* Write values to buffer. */
+int writeValues(circBuff* buffer, const int* src, int n) {
+    // only write as many values as there is space for
+    int count = MAX_BUFFER_LENGTH - buffer->length;
+    if (n < count) {
+        count = n;
+    }
+    if (count <= 0) {
+        return 0;
+    }
+
+    // copy up to the end of the array, then the rest to the start
+    int first = MAX_BUFFER_LENGTH - buffer->writeIndex;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(&buffer->values[buffer->writeIndex], src, first * sizeof(int));
+    memcpy(buffer->values, src + first, (count - first) * sizeof(int));
+
+    // update index values once for the whole batch
+    buffer->writeIndex = (buffer->writeIndex + count) % MAX_BUFFER_LENGTH;
+    buffer->length += count;
+
+    return count;
+}
+
+/* Read values from buffer. */
+int popValues(circBuff* buffer, int* dst, int n) {
+    // only read as many values as are stored
+    int count = buffer->length;
+    if (n < count) {
+        count = n;
+    }
+    if (count <= 0) {
+        return 0;
+    }
+
+    // copy up to the end of the array, then the rest from the start
+    int first = MAX_BUFFER_LENGTH - buffer->readIndex;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(dst, &buffer->values[buffer->readIndex], first * sizeof(int));
+    memcpy(dst + first, buffer->values, (count - first) * sizeof(int));
+
+    // update index values once for the whole batch
+    buffer->readIndex = (buffer->readIndex + count) % MAX_BUFFER_LENGTH;
+    buffer->length -= count;
+
+    return count;
+}
+
 /* Free up memory occupied by buffer. */
 void freeBuffer(circBuff* buffer) {
     // free integer array and the buffer struct
     free(buffer->values);
     free(buffer);
-}
\ No newline at end of file
+}
+
+/* Create SPSC buffer. */
+spscCircBuff* createSpscBuff(size_t capacity) {
+    // round capacity up to a power of two so indexes can be masked
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    // struct is cache line aligned so it can't come from plain malloc()
+    spscCircBuff* buffer = (spscCircBuff*) aligned_alloc(CACHE_LINE_SIZE, sizeof(spscCircBuff));
+    assert(buffer);
+    buffer->values = (int*) calloc(size, sizeof(int));
+    assert(buffer->values);
+
+    buffer->mask = size - 1;
+    buffer->cachedReadIndex = 0;
+    buffer->cachedWriteIndex = 0;
+    atomic_init(&buffer->writeIndex, 0);
+    atomic_init(&buffer->readIndex, 0);
+
+    return buffer;
+}
+
+/* Write value to SPSC buffer. */
+int spscWriteValue(spscCircBuff* buffer, int value) {
+    // only the producer writes 'writeIndex' so a relaxed load is enough
+    size_t write = atomic_load_explicit(&buffer->writeIndex, memory_order_relaxed);
+
+    // refresh the cached read index only if the buffer looks full
+    if (write - buffer->cachedReadIndex > buffer->mask) {
+        buffer->cachedReadIndex = atomic_load_explicit(&buffer->readIndex, memory_order_acquire);
+        if (write - buffer->cachedReadIndex > buffer->mask) {
+            return 0;
+        }
+    }
+
+    // store value, then publish it to the consumer
+    buffer->values[write & buffer->mask] = value;
+    atomic_store_explicit(&buffer->writeIndex, write + 1, memory_order_release);
+
+    return 1;
+}
+
+/* Read value from SPSC buffer. */
+int spscPopValue(spscCircBuff* buffer, int* value) {
+    // only the consumer writes 'readIndex' so a relaxed load is enough
+    size_t read = atomic_load_explicit(&buffer->readIndex, memory_order_relaxed);
+
+    // refresh the cached write index only if the buffer looks empty
+    if (read == buffer->cachedWriteIndex) {
+        buffer->cachedWriteIndex = atomic_load_explicit(&buffer->writeIndex, memory_order_acquire);
+        if (read == buffer->cachedWriteIndex) {
+            return 0;
+        }
+    }
+
+    // read value, then hand the slot back to the producer
+    *value = buffer->values[read & buffer->mask];
+    atomic_store_explicit(&buffer->readIndex, read + 1, memory_order_release);
+
+    return 1;
+}
+
+/* Free up memory occupied by SPSC buffer. */
+void freeSpscBuffer(spscCircBuff* buffer) {
+    free(buffer->values);
+    free(buffer);
+}
+
+/* Create MPMC buffer. */
+mpmcCircBuff* createMpmcBuff(size_t capacity) {
+    // round capacity up to a power of two so indexes can be masked
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    mpmcCircBuff* buffer = (mpmcCircBuff*) aligned_alloc(CACHE_LINE_SIZE, sizeof(mpmcCircBuff));
+    assert(buffer);
+    buffer->slots = (mpmcSlot*) malloc(size * sizeof(mpmcSlot));
+    assert(buffer->slots);
+
+    // slot 'i' is free for the producer that claims index 'i'
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&buffer->slots[i].sequence, i);
+        buffer->slots[i].value = 0;
+    }
+
+    buffer->mask = size - 1;
+    atomic_init(&buffer->writeIndex, 0);
+    atomic_init(&buffer->readIndex, 0);
+
+    return buffer;
+}
+
+/* Write value to MPMC buffer. */
+int mpmcTryWriteValue(mpmcCircBuff* buffer, int value) {
+    size_t write = atomic_load_explicit(&buffer->writeIndex, memory_order_relaxed);
+    mpmcSlot* slot;
+
+    while (1) {
+        slot = &buffer->slots[write & buffer->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t) (sequence - write);
+
+        if (diff == 0) {
+            // slot is free, try to claim index (updates 'write' on failure)
+            if (atomic_compare_exchange_weak_explicit(&buffer->writeIndex, &write, write + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            // slot still holds the value from one lap ago, buffer is full
+            return 0;
+        }
+        else {
+            // another producer claimed this index, catch up
+            write = atomic_load_explicit(&buffer->writeIndex, memory_order_relaxed);
+        }
+    }
+
+    // store value, then hand the slot to the consumer of this index
+    slot->value = value;
+    atomic_store_explicit(&slot->sequence, write + 1, memory_order_release);
+
+    return 1;
+}
+
+/* Read value from MPMC buffer. */
+int mpmcTryPopValue(mpmcCircBuff* buffer, int* value) {
+    size_t read = atomic_load_explicit(&buffer->readIndex, memory_order_relaxed);
+    mpmcSlot* slot;
+
+    while (1) {
+        slot = &buffer->slots[read & buffer->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t) (sequence - (read + 1));
+
+        if (diff == 0) {
+            // slot holds a value, try to claim index (updates 'read' on failure)
+            if (atomic_compare_exchange_weak_explicit(&buffer->readIndex, &read, read + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            // no producer has filled this slot yet, buffer is empty
+            return 0;
+        }
+        else {
+            // another consumer claimed this index, catch up
+            read = atomic_load_explicit(&buffer->readIndex, memory_order_relaxed);
+        }
+    }
+
+    // read value, then hand the slot to the producer one lap ahead
+    *value = slot->value;
+    atomic_store_explicit(&slot->sequence, read + buffer->mask + 1, memory_order_release);
+
+    return 1;
+}
+
+/* Free up memory occupied by MPMC buffer. */
+void freeMpmcBuffer(mpmcCircBuff* buffer) {
+    free(buffer->slots);
+    free(buffer);
+}
+
+/* Hint to the CPU that we are spinning. */
+static inline void cpuRelax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    atomic_signal_fence(memory_order_seq_cst);
+#endif
+}
+
+/* Nanoseconds on the monotonic clock. */
+static long long monotonicNs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/* Sleep on futex word while it still equals 'expected'. A negative
+   timeout sleeps until woken up. */
+static void futexWait(atomic_int* word, int expected, long long timeoutNs) {
+    struct timespec timeout;
+    timeout.tv_sec = timeoutNs / 1000000000LL;
+    timeout.tv_nsec = timeoutNs % 1000000000LL;
+
+    syscall(SYS_futex, (int*) word, FUTEX_WAIT_PRIVATE, expected,
+            (timeoutNs < 0) ? NULL : &timeout, NULL, 0);
+}
+
+/* Wake up all threads sleeping on futex word. */
+static void futexWakeAll(atomic_int* word) {
+    syscall(SYS_futex, (int*) word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+/* Sleep on eventfd until it is readable. */
+static void eventFdWait(int fd, long long timeoutNs) {
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int timeoutMs = (timeoutNs < 0) ? -1 : (int) ((timeoutNs + 999999) / 1000000);
+
+    poll(&pfd, 1, timeoutMs);
+}
+
+/* Adapt spin count after a call that had to wait: double it if
+   spinning was enough, halve it if the call went to sleep anyway. */
+static void updateSpinCount(blockingCircBuff* buffer, int spinWorked) {
+    int spins = atomic_load_explicit(&buffer->spinCount, memory_order_relaxed);
+
+    if (spinWorked && spins < MAX_SPIN_COUNT) {
+        spins *= 2;
+    }
+    else if (!spinWorked && spins > MIN_SPIN_COUNT) {
+        spins /= 2;
+    }
+    atomic_store_explicit(&buffer->spinCount, spins, memory_order_relaxed);
+}
+
+/* Wake consumers up if any are asleep. Called after writing a value. */
+static void notifyConsumers(blockingCircBuff* buffer) {
+    // order the write before reading the waiter count; pairs with the
+    // increment in parkConsumer()
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&buffer->emptyWaiters, memory_order_relaxed) == 0) {
+        return;
+    }
+
+    if (buffer->eventFd != -1) {
+        eventfd_write(buffer->eventFd, 1);
+    }
+    else {
+        atomic_fetch_add(&buffer->notEmpty, 1);
+        futexWakeAll(&buffer->notEmpty);
+    }
+}
+
+/* Wake producers up if any are asleep. Called after reading a value. */
+static void notifyProducers(blockingCircBuff* buffer) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&buffer->fullWaiters, memory_order_relaxed) == 0) {
+        return;
+    }
+
+    atomic_fetch_add(&buffer->notFull, 1);
+    futexWakeAll(&buffer->notFull);
+}
+
+/* Create blocking buffer. */
+blockingCircBuff* createBlockingBuff(size_t capacity, int useEventFd) {
+    int fd = -1;
+    if (useEventFd) {
+        fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (fd == -1) {
+            return NULL;
+        }
+    }
+
+    blockingCircBuff* buffer = (blockingCircBuff*) aligned_alloc(CACHE_LINE_SIZE, sizeof(blockingCircBuff));
+    assert(buffer);
+    buffer->ring = createMpmcBuff(capacity);
+    buffer->eventFd = fd;
+    atomic_init(&buffer->notEmpty, 0);
+    atomic_init(&buffer->emptyWaiters, 0);
+    atomic_init(&buffer->notFull, 0);
+    atomic_init(&buffer->fullWaiters, 0);
+    atomic_init(&buffer->spinCount, MIN_SPIN_COUNT);
+
+    return buffer;
+}
+
+/* Write value, waiting while buffer is full. */
+int pushWait(blockingCircBuff* buffer, int value, long long timeoutNs) {
+    // spin for a bit first, most waits are short
+    int spins = atomic_load_explicit(&buffer->spinCount, memory_order_relaxed);
+    for (int i = 0; i < spins; i++) {
+        if (mpmcTryWriteValue(buffer->ring, value)) {
+            // a success on the first try says nothing about spinning
+            if (i > 0) {
+                updateSpinCount(buffer, 1);
+            }
+            notifyConsumers(buffer);
+            return 1;
+        }
+        if (timeoutNs == 0) {
+            return 0;
+        }
+        cpuRelax();
+    }
+    updateSpinCount(buffer, 0);
+
+    // then sleep until a consumer makes space or time runs out
+    long long deadline = monotonicNs() + timeoutNs;
+    while (1) {
+        int seen = atomic_load(&buffer->notFull);
+        atomic_fetch_add(&buffer->fullWaiters, 1);
+
+        // try again after registering so a pop in between isn't missed
+        if (mpmcTryWriteValue(buffer->ring, value)) {
+            atomic_fetch_sub(&buffer->fullWaiters, 1);
+            notifyConsumers(buffer);
+            return 1;
+        }
+
+        long long remaining = (timeoutNs < 0) ? -1 : deadline - monotonicNs();
+        if (timeoutNs >= 0 && remaining <= 0) {
+            atomic_fetch_sub(&buffer->fullWaiters, 1);
+            return 0;
+        }
+        futexWait(&buffer->notFull, seen, remaining);
+        atomic_fetch_sub(&buffer->fullWaiters, 1);
+    }
+}
+
+/* Read value, waiting while buffer is empty. */
+int popWait(blockingCircBuff* buffer, int* value, long long timeoutNs) {
+    // spin for a bit first, most waits are short
+    int spins = atomic_load_explicit(&buffer->spinCount, memory_order_relaxed);
+    for (int i = 0; i < spins; i++) {
+        if (mpmcTryPopValue(buffer->ring, value)) {
+            // a success on the first try says nothing about spinning
+            if (i > 0) {
+                updateSpinCount(buffer, 1);
+            }
+            notifyProducers(buffer);
+            return 1;
+        }
+        if (timeoutNs == 0) {
+            return 0;
+        }
+        cpuRelax();
+    }
+    updateSpinCount(buffer, 0);
+
+    // then sleep until a producer writes a value or time runs out
+    long long deadline = monotonicNs() + timeoutNs;
+    while (1) {
+        int seen = atomic_load(&buffer->notEmpty);
+
+        // parkConsumer() fails if a value is there already
+        if (parkConsumer(buffer)) {
+            long long remaining = (timeoutNs < 0) ? -1 : deadline - monotonicNs();
+            if (timeoutNs >= 0 && remaining <= 0) {
+                unparkConsumer(buffer);
+                return 0;
+            }
+
+            if (buffer->eventFd != -1) {
+                eventFdWait(buffer->eventFd, remaining);
+            }
+            else {
+                futexWait(&buffer->notEmpty, seen, remaining);
+            }
+            unparkConsumer(buffer);
+        }
+
+        if (mpmcTryPopValue(buffer->ring, value)) {
+            notifyProducers(buffer);
+            return 1;
+        }
+        if (timeoutNs >= 0 && deadline - monotonicNs() <= 0) {
+            return 0;
+        }
+    }
+}
+
+/* Get eventfd of blocking buffer. */
+int blockingBuffFd(blockingCircBuff* buffer) {
+    return buffer->eventFd;
+}
+
+/* Register sleeping consumer. */
+int parkConsumer(blockingCircBuff* buffer) {
+    atomic_fetch_add(&buffer->emptyWaiters, 1);
+
+    // check again after registering so a push in between isn't missed;
+    // pairs with the fence in notifyConsumers()
+    size_t read = atomic_load(&buffer->ring->readIndex);
+    size_t write = atomic_load(&buffer->ring->writeIndex);
+    if (read != write) {
+        atomic_fetch_sub(&buffer->emptyWaiters, 1);
+        return 0;
+    }
+
+    return 1;
+}
+
+/* Unregister sleeping consumer. */
+void unparkConsumer(blockingCircBuff* buffer) {
+    atomic_fetch_sub(&buffer->emptyWaiters, 1);
+
+    // eventfd is non-blocking, reading just resets its counter
+    if (buffer->eventFd != -1) {
+        eventfd_t count;
+        eventfd_read(buffer->eventFd, &count);
+
+        // the reset may have eaten wakeups for other sleeping consumers
+        // too, so pass one on if values are left for them
+        size_t read = atomic_load(&buffer->ring->readIndex);
+        size_t write = atomic_load(&buffer->ring->writeIndex);
+        if (read != write && atomic_load(&buffer->emptyWaiters) > 0) {
+            eventfd_write(buffer->eventFd, 1);
+        }
+    }
+}
+
+/* Free up memory occupied by blocking buffer. */
+void freeBlockingBuffer(blockingCircBuff* buffer) {
+    if (buffer->eventFd != -1) {
+        close(buffer->eventFd);
+    }
+    freeMpmcBuffer(buffer->ring);
+    free(buffer);
+}
+
+/* Value with sequence number 'sequence' in window. */
+static inline int windowValue(windowCircBuff* buffer, size_t sequence) {
+    return buffer->values[sequence % buffer->capacity];
+}
+
+/* Add newly written sequence number to back of deque, first dropping
+   entries that can no longer be the min (or max if 'keepMax' is set). */
+static void dequePushBack(windowCircBuff* buffer, monotonicDeque* deque, size_t sequence, int keepMax) {
+    int value = windowValue(buffer, sequence);
+
+    while (deque->head != deque->tail) {
+        int back = windowValue(buffer, deque->sequences[(deque->tail - 1) % buffer->capacity]);
+        if (keepMax ? (back > value) : (back < value)) {
+            break;
+        }
+        deque->tail--;
+    }
+
+    deque->sequences[deque->tail % buffer->capacity] = sequence;
+    deque->tail++;
+}
+
+/* Remove sequence number of value leaving the window from front of deque. */
+static void dequePopFront(windowCircBuff* buffer, monotonicDeque* deque, size_t sequence) {
+    if (deque->head != deque->tail && deque->sequences[deque->head % buffer->capacity] == sequence) {
+        deque->head++;
+    }
+}
+
+/* Create window buffer. */
+windowCircBuff* createWindowBuff(size_t capacity) {
+    assert(capacity > 0);
+
+    windowCircBuff* buffer = (windowCircBuff*) malloc(sizeof(windowCircBuff));
+    assert(buffer);
+    buffer->values = (int*) calloc(capacity, sizeof(int));
+    buffer->minDeque.sequences = (size_t*) malloc(capacity * sizeof(size_t));
+    buffer->maxDeque.sequences = (size_t*) malloc(capacity * sizeof(size_t));
+    assert(buffer->values && buffer->minDeque.sequences && buffer->maxDeque.sequences);
+
+    buffer->capacity = capacity;
+    buffer->length = 0;
+    buffer->readSequence = 0;
+    buffer->writeSequence = 0;
+    buffer->sum = 0;
+    buffer->minDeque.head = buffer->minDeque.tail = 0;
+    buffer->maxDeque.head = buffer->maxDeque.tail = 0;
+
+    return buffer;
+}
+
+/* Add value to window. */
+void windowWriteValue(windowCircBuff* buffer, int value) {
+    // slide oldest value out if window is full
+    if (buffer->length == buffer->capacity) {
+        int oldest;
+        windowPopValue(buffer, &oldest);
+    }
+
+    size_t sequence = buffer->writeSequence;
+    buffer->values[sequence % buffer->capacity] = value;
+    buffer->writeSequence++;
+    buffer->length++;
+
+    // update aggregates
+    buffer->sum += value;
+    dequePushBack(buffer, &buffer->minDeque, sequence, 0);
+    dequePushBack(buffer, &buffer->maxDeque, sequence, 1);
+}
+
+/* Remove oldest value from window. */
+int windowPopValue(windowCircBuff* buffer, int* value) {
+    if (buffer->length == 0) {
+        return 0;
+    }
+
+    size_t sequence = buffer->readSequence;
+    *value = windowValue(buffer, sequence);
+    buffer->readSequence++;
+    buffer->length--;
+
+    // update aggregates
+    buffer->sum -= *value;
+    dequePopFront(buffer, &buffer->minDeque, sequence);
+    dequePopFront(buffer, &buffer->maxDeque, sequence);
+
+    return 1;
+}
+
+/* Sum of window. */
+long long windowSum(windowCircBuff* buffer) {
+    return buffer->sum;
+}
+
+/* Minimum of window. */
+int windowMin(windowCircBuff* buffer) {
+    assert(buffer->length > 0);
+    return windowValue(buffer, buffer->minDeque.sequences[buffer->minDeque.head % buffer->capacity]);
+}
+
+/* Maximum of window. */
+int windowMax(windowCircBuff* buffer) {
+    assert(buffer->length > 0);
+    return windowValue(buffer, buffer->maxDeque.sequences[buffer->maxDeque.head % buffer->capacity]);
+}
+
+/* Free up memory occupied by window buffer. */
+void freeWindowBuffer(windowCircBuff* buffer) {
+    free(buffer->values);
+    free(buffer->minDeque.sequences);
+    free(buffer->maxDeque.sequences);
+    free(buffer);
+}
+
+/* Create record buffer. */
+recordCircBuff* createRecordBuff(size_t capacity, size_t recordSize) {
+    assert(capacity > 0);
+
+    recordCircBuff* buffer = (recordCircBuff*) malloc(sizeof(recordCircBuff));
+    assert(buffer);
+    buffer->values = (unsigned char*) malloc(capacity * recordSize);
+    assert(buffer->values);
+
+    buffer->capacity = capacity;
+    buffer->recordSize = recordSize;
+    buffer->readIndex = 0;
+    buffer->writeIndex = 0;
+    buffer->length = 0;
+    buffer->dropped = 0;
+
+    return buffer;
+}
+
+/* Write record to buffer, overwriting the oldest one if full. */
+void writeRecord(recordCircBuff* buffer, const void* record) {
+    memcpy(&buffer->values[buffer->writeIndex * buffer->recordSize], record, buffer->recordSize);
+
+    // if full, the record just written replaced the oldest one so the
+    // read index moves along with the write index; written as arithmetic
+    // rather than an if/else so the compiler can avoid branching
+    size_t full = (buffer->length == buffer->capacity);
+    buffer->readIndex += full;
+    buffer->dropped += full;
+    buffer->length += 1 - full;
+    buffer->writeIndex++;
+
+    // wrap around if end of array reached
+    if (buffer->readIndex == buffer->capacity) {
+        buffer->readIndex = 0;
+    }
+    if (buffer->writeIndex == buffer->capacity) {
+        buffer->writeIndex = 0;
+    }
+}
+
+/* Read record from buffer. */
+int popRecord(recordCircBuff* buffer, void* record) {
+    if (buffer->length == 0) {
+        return 0;
+    }
+
+    memcpy(record, &buffer->values[buffer->readIndex * buffer->recordSize], buffer->recordSize);
+    buffer->length--;
+    buffer->readIndex++;
+
+    // wrap around if end of array reached
+    if (buffer->readIndex == buffer->capacity) {
+        buffer->readIndex = 0;
+    }
+
+    return 1;
+}
+
+/* Free up memory occupied by record buffer. */
+void freeRecordBuffer(recordCircBuff* buffer) {
+    free(buffer->values);
+    free(buffer);
+}
+
+/* Checksum of a record mixed with its index (64-bit FNV-1a). */
+static uint64_t recordChecksum(const unsigned char* record, size_t size, uint64_t index) {
+    uint64_t hash = 0xcbf29ce484222325ULL ^ index;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= record[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    // never 0 so that a zero-filled slot is never valid
+    return hash | 1;
+}
+
+/* Address of the slot for free-running 'index'. */
+static unsigned char* persistentSlot(persistentCircBuff* buffer, uint64_t index) {
+    return &buffer->values[(index % buffer->header->capacity) * buffer->slotSize];
+}
+
+/* Open persistent buffer. */
+persistentCircBuff* openPersistentBuff(const char* path, size_t capacity, size_t recordSize) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    // header gets its own page, then one checksum + record per slot
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    size_t slotSize = sizeof(uint64_t) + ((recordSize + 7) & ~(size_t) 7);
+    size_t mappedSize = pageSize + capacity * slotSize;
+
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        return NULL;
+    }
+    int isNew = (info.st_size == 0);
+    if ((isNew && ftruncate(fd, (off_t) mappedSize) == -1) ||
+        (!isNew && (size_t) info.st_size != mappedSize)) {
+        close(fd);
+        return NULL;
+    }
+
+    void* memory = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    persistentCircBuff* buffer = (persistentCircBuff*) malloc(sizeof(persistentCircBuff));
+    assert(buffer);
+    buffer->header = (persistentHeader*) memory;
+    buffer->values = (unsigned char*) memory + pageSize;
+    buffer->slotSize = slotSize;
+    buffer->mappedSize = mappedSize;
+    buffer->fd = fd;
+
+    persistentHeader* header = buffer->header;
+    if (isNew) {
+        // file is zero-filled, so the indexes already start at 0; write
+        // the magic number last so a half-created file isn't recognized
+        header->capacity = capacity;
+        header->recordSize = recordSize;
+        atomic_store(&header->readIndex, 0);
+        atomic_store(&header->writeIndex, 0);
+        atomic_store_explicit((_Atomic uint64_t*) &header->magic, PERSISTENT_MAGIC, memory_order_release);
+    }
+    else if (header->magic != PERSISTENT_MAGIC || header->capacity != capacity ||
+             header->recordSize != recordSize) {
+        closePersistentBuffer(buffer);
+        return NULL;
+    }
+
+    // recovery: keep records up to the first one whose checksum doesn't
+    // match, anything after that was never completely written
+    uint64_t read = atomic_load(&header->readIndex);
+    uint64_t write = atomic_load(&header->writeIndex);
+    uint64_t index = read;
+    while (index != write) {
+        unsigned char* slot = persistentSlot(buffer, index);
+        uint64_t check;
+        memcpy(&check, slot, sizeof(check));
+        if (check != recordChecksum(slot + sizeof(uint64_t), recordSize, index)) {
+            break;
+        }
+        index++;
+    }
+    atomic_store(&header->writeIndex, index);
+    buffer->readCursor = read;
+
+    return buffer;
+}
+
+/* Write record to persistent buffer. */
+int persistentWriteRecord(persistentCircBuff* buffer, const void* record) {
+    persistentHeader* header = buffer->header;
+    uint64_t write = atomic_load_explicit(&header->writeIndex, memory_order_relaxed);
+
+    // return if buffer is full
+    if (write - atomic_load_explicit(&header->readIndex, memory_order_relaxed) == header->capacity) {
+        return 0;
+    }
+
+    // write the record and its checksum before publishing the index
+    unsigned char* slot = persistentSlot(buffer, write);
+    uint64_t check = recordChecksum((const unsigned char*) record, header->recordSize, write);
+    memcpy(slot + sizeof(uint64_t), record, header->recordSize);
+    memcpy(slot, &check, sizeof(check));
+    atomic_store_explicit(&header->writeIndex, write + 1, memory_order_release);
+
+    return 1;
+}
+
+/* Pop record from persistent buffer. */
+int persistentPopRecord(persistentCircBuff* buffer, void* record) {
+    persistentHeader* header = buffer->header;
+    if (buffer->readCursor == atomic_load_explicit(&header->writeIndex, memory_order_acquire)) {
+        return 0;
+    }
+
+    unsigned char* slot = persistentSlot(buffer, buffer->readCursor);
+    memcpy(record, slot + sizeof(uint64_t), header->recordSize);
+    buffer->readCursor++;
+
+    return 1;
+}
+
+/* Commit reads of persistent buffer. */
+void persistentCommitRead(persistentCircBuff* buffer) {
+    atomic_store_explicit(&buffer->header->readIndex, buffer->readCursor, memory_order_release);
+}
+
+/* Flush persistent buffer to disk. */
+int persistentSync(persistentCircBuff* buffer) {
+    // records first, then the header with the indexes that refer to them
+    unsigned char* memory = (unsigned char*) buffer->header;
+    size_t headerSize = (size_t) (buffer->values - memory);
+    if (msync(buffer->values, buffer->mappedSize - headerSize, MS_SYNC) == -1) {
+        return -1;
+    }
+    return msync(memory, headerSize, MS_SYNC);
+}
+
+/* Close persistent buffer. */
+void closePersistentBuffer(persistentCircBuff* buffer) {
+    persistentSync(buffer);
+    munmap(buffer->header, buffer->mappedSize);
+    close(buffer->fd);
+    free(buffer);
+}
+
+/* Create mirrored buffer. */
+mirrorCircBuff* createMirrorBuff(size_t capacity) {
+    // both halves have to start on a page boundary
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    capacity = ((capacity + pageSize - 1) / pageSize) * pageSize;
+    if (capacity == 0) {
+        capacity = pageSize;
+    }
+
+    // anonymous file that provides the memory for both halves
+    int fd = memfd_create("circular_buffer", MFD_CLOEXEC);
+    if (fd == -1) {
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t) capacity) == -1) {
+        close(fd);
+        return NULL;
+    }
+
+    // reserve address space for both halves, then map the file into each
+    unsigned char* values = mmap(NULL, 2 * capacity, PROT_NONE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (values == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    if ((mmap(values, capacity, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) ||
+        (mmap(values + capacity, capacity, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)) {
+        munmap(values, 2 * capacity);
+        close(fd);
+        return NULL;
+    }
+
+    // mappings keep the memory alive, the descriptor isn't needed anymore
+    close(fd);
+
+    mirrorCircBuff* buffer = (mirrorCircBuff*) malloc(sizeof(mirrorCircBuff));
+    assert(buffer);
+    buffer->values = values;
+    buffer->capacity = capacity;
+    buffer->readIndex = 0;
+    buffer->writeIndex = 0;
+    buffer->length = 0;
+
+    return buffer;
+}
+
+/* Peek at stored bytes. */
+unsigned char* mirrorPeekRead(mirrorCircBuff* buffer, size_t* available) {
+    *available = buffer->length;
+    return &buffer->values[buffer->readIndex];
+}
+
+/* Remove peeked bytes. */
+void mirrorCommitRead(mirrorCircBuff* buffer, size_t count) {
+    assert(count <= buffer->length);
+
+    buffer->readIndex += count;
+    buffer->length -= count;
+
+    // move back into the first half
+    if (buffer->readIndex >= buffer->capacity) {
+        buffer->readIndex -= buffer->capacity;
+    }
+}
+
+/* Peek at free bytes. */
+unsigned char* mirrorPeekWrite(mirrorCircBuff* buffer, size_t* available) {
+    *available = buffer->capacity - buffer->length;
+    return &buffer->values[buffer->writeIndex];
+}
+
+/* Add written bytes. */
+void mirrorCommitWrite(mirrorCircBuff* buffer, size_t count) {
+    assert(count <= buffer->capacity - buffer->length);
+
+    buffer->writeIndex += count;
+    buffer->length += count;
+
+    // move back into the first half
+    if (buffer->writeIndex >= buffer->capacity) {
+        buffer->writeIndex -= buffer->capacity;
+    }
+}
+
+/* Free up memory occupied by mirrored buffer. */
+void freeMirrorBuffer(mirrorCircBuff* buffer) {
+    munmap(buffer->values, 2 * buffer->capacity);
+    free(buffer);
+}
+
+/*
+__________________________________________________________________
+
+                            BENCHMARKS
+__________________________________________________________________
+
+*/
+
+#ifdef BENCHMARK
+
+#ifndef BENCHMARK_ITERATIONS
+#define BENCHMARK_ITERATIONS (10000000)
+#endif
+
+#ifndef BENCHMARK_ROUND_TRIPS
+#define BENCHMARK_ROUND_TRIPS (100000)
+#endif
+
+#ifndef BENCHMARK_CAPACITY
+#define BENCHMARK_CAPACITY (1024)
+#endif
+
+/* circBuff behind a mutex, i.e. what has to be done to share it today. */
+struct lockedCircBuff {
+    pthread_mutex_t lock;
+    circBuff* buffer;
+} typedef lockedCircBuff;
+
+/* Pair of buffers used by the benchmark threads. 'reply' is only used
+   by the latency benchmark. */
+struct benchmarkArgs {
+    spscCircBuff* spsc;
+    spscCircBuff* spscReply;
+    lockedCircBuff* locked;
+    lockedCircBuff* lockedReply;
+    long count;
+} typedef benchmarkArgs;
+
+/* Seconds between two timestamps. */
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/* Write value to locked buffer. Returns 0 if the buffer is full. */
+static int lockedWriteValue(lockedCircBuff* locked, int value) {
+    pthread_mutex_lock(&locked->lock);
+
+    // check length first so that writeValue() doesn't print
+    if (locked->buffer->length == MAX_BUFFER_LENGTH) {
+        pthread_mutex_unlock(&locked->lock);
+        return 0;
+    }
+    writeValue(locked->buffer, value);
+
+    pthread_mutex_unlock(&locked->lock);
+    return 1;
+}
+
+/* Read value from locked buffer. Returns 0 if the buffer is empty. */
+static int lockedPopValue(lockedCircBuff* locked, int* value) {
+    pthread_mutex_lock(&locked->lock);
+
+    // check length first so that popValue() doesn't print
+    if (locked->buffer->length == 0) {
+        pthread_mutex_unlock(&locked->lock);
+        return 0;
+    }
+    *value = popValue(locked->buffer);
+
+    pthread_mutex_unlock(&locked->lock);
+    return 1;
+}
+
+/* Create a locked buffer. */
+static lockedCircBuff* createLockedBuff(void) {
+    lockedCircBuff* locked = (lockedCircBuff*) malloc(sizeof(lockedCircBuff));
+    assert(locked);
+    pthread_mutex_init(&locked->lock, NULL);
+
+    locked->buffer = (circBuff*) malloc(sizeof(circBuff));
+    assert(locked->buffer);
+    initializeBuff(locked->buffer, MAX_BUFFER_LENGTH);
+
+    return locked;
+}
+
+/* Free a locked buffer. */
+static void freeLockedBuffer(lockedCircBuff* locked) {
+    pthread_mutex_destroy(&locked->lock);
+    freeBuffer(locked->buffer);
+    free(locked);
+}
+
+/* Consumer threads, pop 'count' values. The producer is the main thread. */
+static void* spscConsumer(void* arg) {
+    benchmarkArgs* args = (benchmarkArgs*) arg;
+    long sum = 0;
+    int value;
+
+    for (long i = 0; i < args->count; i++) {
+        while (!spscPopValue(args->spsc, &value)) {
+            sched_yield();
+        }
+        sum += value;
+    }
+
+    return (void*) sum;
+}
+
+static void* lockedConsumer(void* arg) {
+    benchmarkArgs* args = (benchmarkArgs*) arg;
+    long sum = 0;
+    int value;
+
+    for (long i = 0; i < args->count; i++) {
+        while (!lockedPopValue(args->locked, &value)) {
+            sched_yield();
+        }
+        sum += value;
+    }
+
+    return (void*) sum;
+}
+
+/* Echo threads, send every value straight back on the reply buffer. */
+static void* spscEcho(void* arg) {
+    benchmarkArgs* args = (benchmarkArgs*) arg;
+    int value;
+
+    for (long i = 0; i < args->count; i++) {
+        while (!spscPopValue(args->spsc, &value)) {
+            sched_yield();
+        }
+        while (!spscWriteValue(args->spscReply, value)) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void* lockedEcho(void* arg) {
+    benchmarkArgs* args = (benchmarkArgs*) arg;
+    int value;
+
+    for (long i = 0; i < args->count; i++) {
+        while (!lockedPopValue(args->locked, &value)) {
+            sched_yield();
+        }
+        while (!lockedWriteValue(args->lockedReply, value)) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/* Run SPSC benchmarks. */
+void benchmarkSpsc(void) {
+    struct timespec start, end;
+    pthread_t thread;
+    void* result;
+    int value;
+
+    benchmarkArgs args;
+    args.spsc = createSpscBuff(BENCHMARK_CAPACITY);
+    args.spscReply = createSpscBuff(BENCHMARK_CAPACITY);
+    args.locked = createLockedBuff();
+    args.lockedReply = createLockedBuff();
+
+    printf("\nSPSC vs mutex-wrapped circBuff (capacity %d)\n", MAX_BUFFER_LENGTH);
+
+    // throughput: main thread produces, second thread consumes; the
+    // first SPSC run has (about) the capacity of the circBuff so that
+    // it compares the locking only, the second one a larger buffer
+    args.count = BENCHMARK_ITERATIONS;
+    spscCircBuff* large = args.spsc;
+    spscCircBuff* spscBuffers[] = { createSpscBuff(MAX_BUFFER_LENGTH), large };
+
+    for (int b = 0; b < 2; b++) {
+        args.spsc = spscBuffers[b];
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        pthread_create(&thread, NULL, spscConsumer, &args);
+        for (long i = 0; i < args.count; i++) {
+            while (!spscWriteValue(args.spsc, (int) i)) {
+                sched_yield();
+            }
+        }
+        pthread_join(thread, &result);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("  spsc   throughput: %8.2f Mops/s (capacity %4zu, checksum %ld)\n",
+               args.count / elapsedSeconds(start, end) / 1e6, args.spsc->mask + 1, (long) result);
+    }
+    freeSpscBuffer(spscBuffers[0]);
+    args.spsc = large;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&thread, NULL, lockedConsumer, &args);
+    for (long i = 0; i < args.count; i++) {
+        while (!lockedWriteValue(args.locked, (int) i)) {
+            sched_yield();
+        }
+    }
+    pthread_join(thread, &result);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  locked throughput: %8.2f Mops/s (capacity %4d, checksum %ld)\n",
+           args.count / elapsedSeconds(start, end) / 1e6, MAX_BUFFER_LENGTH, (long) result);
+
+    // latency: ping-pong one value at a time and time the round trips
+    args.count = BENCHMARK_ROUND_TRIPS;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&thread, NULL, spscEcho, &args);
+    for (long i = 0; i < args.count; i++) {
+        spscWriteValue(args.spsc, (int) i);
+        while (!spscPopValue(args.spscReply, &value)) {
+            sched_yield();
+        }
+    }
+    pthread_join(thread, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  spsc   round trip: %8.0f ns\n",
+           elapsedSeconds(start, end) / args.count * 1e9);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&thread, NULL, lockedEcho, &args);
+    for (long i = 0; i < args.count; i++) {
+        lockedWriteValue(args.locked, (int) i);
+        while (!lockedPopValue(args.lockedReply, &value)) {
+            sched_yield();
+        }
+    }
+    pthread_join(thread, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  locked round trip: %8.0f ns\n",
+           elapsedSeconds(start, end) / args.count * 1e9);
+
+    freeSpscBuffer(args.spsc);
+    freeSpscBuffer(args.spscReply);
+    freeLockedBuffer(args.locked);
+    freeLockedBuffer(args.lockedReply);
+}
+
+#define MPMC_MAX_THREADS (16)
+
+/* Arguments for a MPMC benchmark thread. */
+struct mpmcBenchmarkArgs {
+    mpmcCircBuff* buffer;
+    long count;
+    long sum;
+} typedef mpmcBenchmarkArgs;
+
+/* Alternate between pushing and popping so that every thread is both
+   a producer and a consumer. */
+static void* mpmcWorker(void* arg) {
+    mpmcBenchmarkArgs* args = (mpmcBenchmarkArgs*) arg;
+    int value;
+
+    args->sum = 0;
+    for (long i = 0; i < args->count; i++) {
+        while (!mpmcTryWriteValue(args->buffer, (int) i)) {
+            sched_yield();
+        }
+        while (!mpmcTryPopValue(args->buffer, &value)) {
+            sched_yield();
+        }
+        args->sum += value;
+    }
+
+    return NULL;
+}
+
+/* Run MPMC benchmarks. */
+void benchmarkMpmc(void) {
+    struct timespec start, end;
+    pthread_t threads[MPMC_MAX_THREADS];
+    mpmcBenchmarkArgs args[MPMC_MAX_THREADS];
+
+    printf("\nMPMC scaling (capacity %d, %d push/pop pairs in total)\n",
+           BENCHMARK_CAPACITY, BENCHMARK_ITERATIONS);
+
+    for (int numThreads = 1; numThreads <= MPMC_MAX_THREADS; numThreads *= 2) {
+        mpmcCircBuff* buffer = createMpmcBuff(BENCHMARK_CAPACITY);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int t = 0; t < numThreads; t++) {
+            args[t].buffer = buffer;
+            args[t].count = BENCHMARK_ITERATIONS / numThreads;
+            pthread_create(&threads[t], NULL, mpmcWorker, &args[t]);
+        }
+        long sum = 0;
+        long pairs = 0;
+        for (int t = 0; t < numThreads; t++) {
+            pthread_join(threads[t], NULL);
+            sum += args[t].sum;
+            pairs += args[t].count;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        printf("  %2d threads: %8.2f Mops/s (checksum %ld)\n", numThreads,
+               2.0 * pairs / elapsedSeconds(start, end) / 1e6, sum);
+
+        freeMpmcBuffer(buffer);
+    }
+}
+
+#endif
@@ -1,14 +1,80 @@
 /** @file   dynamic_list.c
  *  @brief  An implementation of a dynamic list of integers using arrays in C.
+ *          Searching and reducing the list (find, count, sum, min/max and
+ *          filter) uses AVX-512 or AVX2 kernels when the CPU supports them.
+ *          Lists can optionally be stored as a gap buffer, which makes
+ *          inserts and deletes close to the previous edit cheap.
+ *          Sorting uses radix sort, split across threads for large lists.
+ *          Compile with -DTEST to run the tests and -DBENCHMARK to run the
+ *          benchmarks.
  *  @author Mustafa Siddiqui
  *  @date   01/06/2020
  */
 
+#define _GNU_SOURCE                 // mremap()
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>                 // memcpy()
+#include <sys/mman.h>               // mmap(), mremap()
+#include <unistd.h>                 // sysconf()
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#ifdef BENCHMARK
+#include <time.h>                   // clock_gettime()
+#include <sys/resource.h>           // getrusage()
+#include <sys/wait.h>               // waitpid()
+#endif
+
+/* Default capacity and growth factor of a new list */
+#define DEFAULT_CAPACITY (5)
+#define DEFAULT_GROWTH_FACTOR (2.0)
+
+/* Lists shorter than this are sorted with insertion sort */
+#define INSERTION_SORT_THRESHOLD (32)
+
+/* Lists at least this long are sorted with several threads */
+#define PARALLEL_SORT_THRESHOLD (1 << 20)
+
+/* Upper limit for the number of sorting threads */
+#define MAX_SORT_THREADS (64)
 
-/* Updated as list expands or shrinks */
-volatile int MAX_SIZE = 5;
+/* Lists that use mremap() switch to mmap()'d memory at this size */
+#define MREMAP_THRESHOLD (1 << 20)
+
+/*
+    Struct to hold a dynamic list. Each list tracks its own capacity.
+    -   'end' is the index of the last element (-1 if the list is empty)
+    -   capacity grows by 'growthFactor' when the list is full
+    -   capacity halves when the list drops below a quarter full, so
+        alternating inserts and deletes at a boundary don't keep
+        resizing the array
+    -   if 'useMremap' is set, arrays of MREMAP_THRESHOLD bytes or more
+        are mmap()'d and resized with mremap(), which moves pages around
+        instead of copying elements; 'isMapped' says which one is in use
+    -   if 'useGapBuffer' is set, the free space of the array (the gap)
+        is kept where the last insert/delete happened instead of at the
+        end: elements before 'gapStart' are at their own index and the
+        rest are shifted up by the size of the gap. An edit only moves
+        the elements between the gap and the edit. Operations that need
+        the elements in one piece first move the gap back to the end
+        ("close" it), which is the normal layout of the list.
+*/
+struct dynamicList {
+    int* values;
+    int end;
+    int capacity;
+    double growthFactor;
+    int useMremap;
+    int isMapped;
+    int useGapBuffer;
+    int gapStart;
+} typedef dynamicList;
 
 /*
 __________________________________________________________________
@@ -18,11 +84,11 @@ __________________________________________________________________
 
 */
 
-/* 
+/*
     ** The following is done for experimental purposes. It is not recommended to do so. **
-    Use insertElement() with either 3 or 4 arguments.
+    Use insertElement() with either 2 or 3 arguments.
     The following has the same result as if the function was overloaded. (not allowed in C)
-    insertElement is actually a macro with expands to the functions insertElement3 or insertElement4
+    insertElement is actually a macro with expands to the functions insertElement2 or insertElement3
     depending on the number of arguments passed to it.
     If an element needs to be inserted at a specific position, include the index in arguments as well.
     Otherwise, the element would be added at the end of the list.
@@ -35,40 +101,170 @@ __________________________________________________________________
 
 #define insertElement(...) CONC(insertElement, NARGS(__VA_ARGS__))(__VA_ARGS__)
 
-void insertElement3(int* list, int value, int* end);
-int insertElement4(int* list, int value, int index, int* end);
+int insertElement2(dynamicList* list, int value);
+int insertElement3(dynamicList* list, int value, int index);
+
+/*
+    Allocate memory for and initialize an empty list with room for
+    'numElements' elements, using the default growth factor.
+    Returns NULL if there is not enough memory.
+*/
+dynamicList* initializeList(int numElements);
+
+/*
+    Same as initializeList() but with a custom growth factor (must be
+    greater than 1) and optionally using mremap() for large arrays.
+*/
+dynamicList* initializeListWithOptions(int numElements, double growthFactor, int useMremap);
+
+/*
+    Make sure the list has room for at least 'capacity' elements.
+    Returns 1 on success and 0 if there is not enough memory.
+*/
+int reserveList(dynamicList* list, int capacity);
+
+/*
+    Reduce the capacity of the list to its length.
+    Returns 1 on success and 0 if there is not enough memory.
+*/
+int shrinkToFit(dynamicList* list);
 
 /*
-    Allocate memory for and initialize the list with 0s.
-    'end' keeps track of the current last element of the list.
+    Insert 'n' elements from 'src' before 'index' (or at the end if
+    'index' is the length of the list). Does at most one reallocation
+    and one memmove.
+    Returns 1 on success and 0 if the index is past the end of the list
+    or there is not enough memory (no elements are added to list).
 */
-int* initializeList(int numElements, int* end);
+int insertRange(dynamicList* list, int index, const int* src, int n);
+
+/*
+    Append 'n' elements from 'src' to the end of the list.
+    Returns 1 on success and 0 if there is not enough memory.
+*/
+int appendRange(dynamicList* list, const int* src, int n);
+
+/*
+    Remove elements with index in [first, last) from the list. Does at
+    most one memmove and one reallocation.
+    Returns the number of elements removed (0 if the range is invalid).
+*/
+int eraseRange(dynamicList* list, int first, int last);
+
+/*
+    Merge 'n' sorted elements from 'src' into a sorted list so that the
+    list stays sorted. Every element is moved at most once.
+    Returns 1 on success and 0 if there is not enough memory.
+*/
+int mergeSortedRange(dynamicList* list, const int* src, int n);
+
+/*
+    Turn gap buffer storage on or off for the list.
+*/
+void setGapBuffer(dynamicList* list, int enable);
+
+/*
+    Return element at a specific position. O(1) with either storage.
+    The index must be valid.
+*/
+int getElement(dynamicList* list, int index);
 
 /*
     Print all elements in the list.
 */
-void printList(int* list, int* end);
+void printList(dynamicList* list);
 
 /*
     Print element at a specific position to console.
 */
-void displayElement(int* list, int index, int* end);
+void displayElement(dynamicList* list, int index);
 
 /*
     Find number of elements in the list.
-    Subsequently, 'end' denotes (length of list - 1).
 */
-int lengthOfList(int* list, int* end);
+int lengthOfList(dynamicList* list);
 
 /*
     Delete element at a specific position from list.
 */
-void deleteElement(int* list, int index, int *end);
+void deleteElement(dynamicList* list, int index);
 
 /*
     Delete the whole list by freeing memory.
 */
-void deleteList(int* list);
+void deleteList(dynamicList* list);
+
+/*
+    Return the index of the first element equal to 'value', or -1 if
+    the value is not in the list.
+*/
+int findFirst(dynamicList* list, int value);
+
+/*
+    Return the number of elements equal to 'value'.
+*/
+int countEqual(dynamicList* list, int value);
+
+/*
+    Return the sum of all elements.
+*/
+long long sumList(dynamicList* list);
+
+/*
+    Find the smallest and largest element in the list.
+    Returns 0 if the list is empty (min and max are not set) and 1
+    otherwise.
+*/
+int minMaxList(dynamicList* list, int* min, int* max);
+
+/*
+    Create a new list with the elements of 'list' that are between
+    'low' and 'high' (inclusive), in the same order.
+    Returns NULL if there is not enough memory.
+*/
+dynamicList* filterList(dynamicList* list, int low, int high);
+
+/*
+    Name of the instruction set used by the functions above ("avx512",
+    "avx2" or "scalar").
+*/
+const char* listKernelName(void);
+
+/*
+    Sort the list in ascending order. Uses insertion sort for short
+    lists, LSD radix sort otherwise, and for long lists radix sorts
+    one part per thread and then merges the parts in parallel.
+    'numThreads' of 0 uses one thread per CPU.
+    Returns 1 on success and 0 if there is not enough memory (the list
+    is left unchanged).
+*/
+int sortList(dynamicList* list, int numThreads);
+
+#ifdef BENCHMARK
+/*
+    Amortized cost of appending to a list and the peak memory used,
+    for different growth factors and with/without mremap().
+*/
+void benchmarkPushBack(void);
+
+/*
+    Inserts and deletes in the middle of a large list, with and without
+    gap buffer storage.
+*/
+void benchmarkMiddleEdits(void);
+
+/*
+    Bandwidth of the scan and reduce functions for the scalar and the
+    best available kernels.
+*/
+void benchmarkKernels(void);
+
+/*
+    Sorting random integers with qsort() vs sortList() with 1 thread
+    and with one thread per CPU.
+*/
+void benchmarkSort(void);
+#endif
 
 /*
 __________________________________________________________________
@@ -81,28 +277,77 @@ int main(void) {
 
     // test the list implementation
     #ifdef TEST
-        int end = 0;
-        int* dynamicList = initializeList(MAX_SIZE, &end);
-        if (dynamicList == NULL) {
+        dynamicList* list = initializeList(DEFAULT_CAPACITY);
+        if (list == NULL) {
             printf("Not enough memory. Line %d\n", __LINE__);
             exit(EXIT_FAILURE);
         }
 
         for (int j = 0; j < 20; j++) {
-            insertElement(dynamicList, (j+1), &end);
+            insertElement(list, (j+1));
+        }
+        printList(list);
+        printf("Length of list: %d\n", lengthOfList(list));
+
+        insertElement(list, 99, 4);
+        printList(list);
+        printf("Length of list: %d\n", lengthOfList(list));
+
+        deleteElement(list, 4);
+        printList(list);
+        printf("Length of list: %d\n", lengthOfList(list));
+
+        // capacity only shrinks once the list is below a quarter full
+        for (int j = 0; j < 15; j++) {
+            deleteElement(list, 0);
+        }
+        printf("Length %d, capacity %d\n", lengthOfList(list), list->capacity);
+        shrinkToFit(list);
+        printf("Length %d, capacity %d\n", lengthOfList(list), list->capacity);
+
+        // scan and reduce
+        for (int j = 0; j < 40; j++) {
+            insertElement(list, (j * 7) % 23);
         }
-        printList(dynamicList, &end);
-        printf("Length of list: %d\n", lengthOfList(dynamicList, &end));
+        printList(list);
+        int min, max;
+        minMaxList(list, &min, &max);
+        printf("Using %s: find(15) %d, count(15) %d, sum %lld, min %d, max %d\n",
+               listKernelName(), findFirst(list, 15), countEqual(list, 15),
+               sumList(list), min, max);
+        dynamicList* filtered = filterList(list, 5, 10);
+        printList(filtered);
+        deleteList(filtered);
+
+        // range edits
+        int batch[] = { -3, -2, -1 };
+        insertRange(list, 2, batch, 3);
+        appendRange(list, batch, 3);
+        printList(list);
+        eraseRange(list, 0, 10);
+        printList(list);
 
-        insertElement(dynamicList, 99, 4, &end);
-        printList(dynamicList, &end);
-        printf("Length of list: %d\n", lengthOfList(dynamicList, &end));
+        // sort
+        sortList(list, 0);
+        printList(list);
 
-        deleteElement(dynamicList, 4, &end);
-        printList(dynamicList, &end);
-        printf("Length of list: %d\n", lengthOfList(dynamicList, &end));
+        // same edits with gap buffer storage
+        setGapBuffer(list, 1);
+        for (int j = 0; j < 5; j++) {
+            insertElement(list, 100 + j, 10 + j);
+        }
+        deleteElement(list, 12);
+        printf("%d %d %d\n", getElement(list, 10), getElement(list, 12), getElement(list, 40));
+        printList(list);
 
-        deleteList(dynamicList);
+        deleteList(list);
+    #endif
+
+    #ifdef BENCHMARK
+        benchmarkPushBack();
+        benchmarkKernels();
+        benchmarkMiddleEdits();
+        benchmarkSort();
     #endif
 
     return 0;
@@ -116,111 +361,1197 @@ __________________________________________________________________
 
 */
 
-/* Initialize list and 'end' */
-int* initializeList(int numElements, int* end) {
+/* Size in bytes of a mapping for 'capacity' elements. */
+static size_t mappedSize(int capacity) {
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    size_t bytes = (size_t) capacity * sizeof(int);
+
+    return ((bytes + pageSize - 1) / pageSize) * pageSize;
+}
+
+/* Move gap so that it starts at 'index'. */
+static void moveGap(dynamicList* list, int index) {
+    int gapLength = list->capacity - (list->end + 1);
+
+    if (index < list->gapStart) {
+        // elements in [index, gapStart) move to after the gap
+        memmove(&list->values[index + gapLength], &list->values[index],
+                (size_t) (list->gapStart - index) * sizeof(int));
+    }
+    else if (index > list->gapStart) {
+        // elements in [gapStart, index) move to before the gap
+        memmove(&list->values[list->gapStart], &list->values[list->gapStart + gapLength],
+                (size_t) (index - list->gapStart) * sizeof(int));
+    }
+    list->gapStart = index;
+}
+
+/* Move gap to end of list so the elements are in one piece. */
+static void closeGap(dynamicList* list) {
+    moveGap(list, list->end + 1);
+}
+
+/* Move list to an array of 'newCapacity' elements. Returns 0 if there is
+   not enough memory, in which case the list is left unchanged. */
+static int resizeList(dynamicList* list, int newCapacity) {
+    closeGap(list);
+
+    if (newCapacity < 1) {
+        newCapacity = 1;
+    }
+    size_t newBytes = (size_t) newCapacity * sizeof(int);
+    size_t usedBytes = (size_t) (list->end + 1) * sizeof(int);
+    int* values;
+
+    // large array with mremap(): let the kernel move the pages
+    if (list->useMremap && newBytes >= MREMAP_THRESHOLD) {
+        if (list->isMapped) {
+            values = mremap(list->values, mappedSize(list->capacity),
+                            mappedSize(newCapacity), MREMAP_MAYMOVE);
+            if (values == MAP_FAILED) {
+                return 0;
+            }
+        }
+        else {
+            // first time over the threshold, copy once into a mapping
+            values = mmap(NULL, mappedSize(newCapacity), PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (values == MAP_FAILED) {
+                return 0;
+            }
+            memcpy(values, list->values, usedBytes);
+            free(list->values);
+        }
+        list->isMapped = 1;
+    }
+    // small array, or shrunk back below the threshold
+    else {
+        if (list->isMapped) {
+            values = (int*) malloc(newBytes);
+            if (values == NULL) {
+                return 0;
+            }
+            memcpy(values, list->values, usedBytes);
+            munmap(list->values, mappedSize(list->capacity));
+        }
+        else {
+            values = (int*) realloc(list->values, newBytes);
+            if (values == NULL) {
+                return 0;
+            }
+        }
+        list->isMapped = 0;
+    }
+
+    list->values = values;
+    list->capacity = newCapacity;
+
+    return 1;
+}
+
+/* Grow list if there isn't room for 'count' more elements. Returns 0 if
+   there is not enough memory. */
+static int growFor(dynamicList* list, int count) {
+    int required = list->end + 1 + count;
+    if (required <= list->capacity) {
+        return 1;
+    }
+
+    // always grow by at least one element, even for factors close to 1,
+    // and at least enough for all new elements
+    int newCapacity = (int) (list->capacity * list->growthFactor);
+    if (newCapacity <= list->capacity) {
+        newCapacity = list->capacity + 1;
+    }
+    if (newCapacity < required) {
+        newCapacity = required;
+    }
+
+    return resizeList(list, newCapacity);
+}
+
+/* Shrink list once it is below a quarter full. */
+static void shrinkIfSparse(dynamicList* list) {
+    // halving leaves the list half full so it takes many operations
+    // either way before the next resize
+    int newCapacity = list->capacity;
+    while (list->end + 1 < newCapacity / 4) {
+        newCapacity /= 2;
+    }
+    if (newCapacity != list->capacity) {
+        resizeList(list, newCapacity);
+    }
+}
+
+/* Initialize list with default options */
+dynamicList* initializeList(int numElements) {
+    return initializeListWithOptions(numElements, DEFAULT_GROWTH_FACTOR, 0);
+}
+
+/* Initialize list */
+dynamicList* initializeListWithOptions(int numElements, double growthFactor, int useMremap) {
     // allocate memory for list
-    int* dynamicList = (int*)malloc(numElements * sizeof(int));
-    if (dynamicList == NULL) {
+    dynamicList* list = (dynamicList*) malloc(sizeof(dynamicList));
+    if (list == NULL) {
         return NULL;
     }
 
-    // initialize to zero
-    for (int i = 0; i < numElements; i++) {
-        dynamicList[i] = 0;
-    }
+    list->values = NULL;
+    list->capacity = 0;
+    list->growthFactor = (growthFactor > 1.0) ? growthFactor : DEFAULT_GROWTH_FACTOR;
+    list->useMremap = useMremap;
+    list->isMapped = 0;
+    list->useGapBuffer = 0;
+    list->gapStart = 0;
 
     // indicates list is empty
-    *end = -1;
+    list->end = -1;
 
-    return dynamicList;
+    if (!resizeList(list, numElements)) {
+        free(list);
+        return NULL;
+    }
+
+    return list;
 }
 
-/* Insert element at end of list */
-void insertElement3(int* list, int value, int* end) {
-    // expand list if full
-    if (*end == MAX_SIZE) {
-        MAX_SIZE *= 2;
-        list = realloc(list, MAX_SIZE* sizeof(int));
+/* Reserve capacity */
+int reserveList(dynamicList* list, int capacity) {
+    if (capacity <= list->capacity) {
+        return 1;
     }
+    return resizeList(list, capacity);
+}
 
-    // if list not empty, insert at end
-    if (*end != -1) {
-        list[*end + 1] = value;
+/* Shrink capacity to length */
+int shrinkToFit(dynamicList* list) {
+    if (list->end + 1 == list->capacity) {
+        return 1;
     }
-    // if list empty, insert at start
-    else {
-        list[0] = value;
+    return resizeList(list, list->end + 1);
+}
+
+/* Switch gap buffer on or off */
+void setGapBuffer(dynamicList* list, int enable) {
+    // the other functions expect the gap at the end without a gap buffer
+    if (!enable) {
+        closeGap(list);
     }
-    (*end)++;
+    list->useGapBuffer = enable;
 }
 
-/* Insert element at a specific index. Returns 0 if list is empty (no element is added to list) */
-int insertElement4(int* list, int value, int index, int* end) {
+/* Get element at index */
+int getElement(dynamicList* list, int index) {
+    if (index < list->gapStart) {
+        return list->values[index];
+    }
+    return list->values[index + list->capacity - (list->end + 1)];
+}
+
+/* Insert element at end of list */
+int insertElement2(dynamicList* list, int value) {
     // expand list if full
-    if (*end == MAX_SIZE) {
-        MAX_SIZE *= 2;
-        list = realloc(list, MAX_SIZE* sizeof(int));
+    if (!growFor(list, 1)) {
+        return 0;
     }
 
-    // if list not empty, shift elements after and including index down
-    if (*end != -1) {
-        for (int i = *end; i >= index; i--) {
-            list[i + 1] = list[i];
-        }
-        (*end)++;
-        list[index] = value;
+    closeGap(list);
+
+    list->values[list->end + 1] = value;
+    list->end++;
+    list->gapStart = list->end + 1;
+
+    return 1;
+}
+
+/* Insert element at a specific index. Returns 0 if the index is past the end of the
+   list or there is not enough memory (no element is added to list) */
+int insertElement3(dynamicList* list, int value, int index) {
+    return insertRange(list, index, &value, 1);
+}
+
+/* Insert elements at a specific index */
+int insertRange(dynamicList* list, int index, const int* src, int n) {
+    if (index < 0 || index > list->end + 1 || n < 0) {
+        return 0;
+    }
+
+    // expand list once for all elements
+    if (!growFor(list, n)) {
+        return 0;
+    }
+
+    // with a gap buffer, move the gap to index and fill its start
+    if (list->useGapBuffer) {
+        moveGap(list, index);
+        memcpy(&list->values[index], src, (size_t) n * sizeof(int));
+        list->gapStart += n;
+        list->end += n;
         return 1;
     }
-    // return 0 if list empty
+
+    // shift elements after and including index down in one go
+    memmove(&list->values[index + n], &list->values[index],
+            (size_t) (list->end + 1 - index) * sizeof(int));
+    memcpy(&list->values[index], src, (size_t) n * sizeof(int));
+    list->end += n;
+    list->gapStart = list->end + 1;
+
+    return 1;
+}
+
+/* Insert elements at end of list */
+int appendRange(dynamicList* list, const int* src, int n) {
+    return insertRange(list, list->end + 1, src, n);
+}
+
+/* Remove elements in [first, last) */
+int eraseRange(dynamicList* list, int first, int last) {
+    if (first < 0 || last > list->end + 1 || first >= last) {
+        return 0;
+    }
+    int n = last - first;
+
+    // with a gap buffer, move the gap to first; the n elements right after
+    // the gap become part of it once the list is n shorter
+    if (list->useGapBuffer) {
+        moveGap(list, first);
+        list->end -= n;
+    }
+    // shift elements after the range up in one go
     else {
+        memmove(&list->values[first], &list->values[last],
+                (size_t) (list->end + 1 - last) * sizeof(int));
+        list->end -= n;
+        list->gapStart = list->end + 1;
+    }
+
+    shrinkIfSparse(list);
+
+    return n;
+}
+
+/* Merge sorted elements into sorted list */
+int mergeSortedRange(dynamicList* list, const int* src, int n) {
+    if (n <= 0) {
+        return 1;
+    }
+    if (!growFor(list, n)) {
         return 0;
     }
+    closeGap(list);
+
+    // merge from the back into the free space so nothing is overwritten
+    // before it has been moved
+    int i = list->end;
+    int j = n - 1;
+    int k = list->end + n;
+    while (j >= 0) {
+        if (i >= 0 && list->values[i] > src[j]) {
+            list->values[k--] = list->values[i--];
+        }
+        else {
+            list->values[k--] = src[j--];
+        }
+    }
+    list->end += n;
+    list->gapStart = list->end + 1;
+
+    return 1;
 }
 
 /* Print whole list on a single line */
-void printList(int* list, int* end) {
-    for (int i = 0; i < *end; i++) {
-        printf("%d ", list[i]);
+void printList(dynamicList* list) {
+    closeGap(list);
+    for (int i = 0; i <= list->end; i++) {
+        printf("%d ", list->values[i]);
     }
     putc('\n', stdout);
 }
 
 /* Print an element at a specific index */
-void displayElement(int* list, int index, int* end) {
-    if (index > *end) {
+void displayElement(dynamicList* list, int index) {
+    if (index > list->end) {
         printf("List is empty at index %d.\n", index);
     }
     else {
-        printf("%d\n", list[index]);
+        printf("%d\n", getElement(list, index));
     }
 }
 
 /* Return the number of elements in the list */
-int lengthOfList(int* list, int* end) {
-    return (*end + 1);
+int lengthOfList(dynamicList* list) {
+    return (list->end + 1);
 }
 
 /* Remove element from a specific index from the list */
-void deleteElement(int* list, int index, int* end) {
-    // reduce size if appropriate
-    if (*end < (MAX_SIZE / 2)) {
-        MAX_SIZE /= 2;
-        list = realloc(list, MAX_SIZE * sizeof(int));
+void deleteElement(dynamicList* list, int index) {
+    if (index < 0 || index > list->end) {
+        printf("No element at index %d.\n", index);
+        return;
     }
 
-    if (index > *end) {
-        printf("No element at index %d.\n", index);
+    eraseRange(list, index, index + 1);
+}
+
+/* Free the allocated memory for the list */
+void deleteList(dynamicList* list) {
+    if (list->isMapped) {
+        munmap(list->values, mappedSize(list->capacity));
     }
-    // shift elements after index up
     else {
-        for (int i = index; i <= *end; i++) {
-            list[i] = list[i + 1];
+        free(list->values);
+    }
+    free(list);
+}
+
+/*
+__________________________________________________________________
+
+                        SCAN/REDUCE KERNELS
+__________________________________________________________________
+
+*/
+
+/*
+    Set of kernels for one instruction set. Each works on a plain array
+    of 'n' elements. 'filter' writes matching elements to 'dst' (which
+    must have room for 'n' elements) and returns how many it wrote.
+*/
+struct listKernels {
+    const char* name;
+    int (*findFirst)(const int* values, int n, int value);
+    int (*countEqual)(const int* values, int n, int value);
+    long long (*sum)(const int* values, int n);
+    void (*minMax)(const int* values, int n, int* min, int* max);
+    int (*filter)(const int* values, int n, int low, int high, int* dst);
+} typedef listKernels;
+
+/*
+    Scalar kernels. These are also the fallback on x86 CPUs without
+    AVX2, where the compiler vectorizes the count/sum/min/max loops
+    with SSE2 (which every x86-64 CPU has).
+*/
+static int scalarFindFirst(const int* values, int n, int value) {
+    for (int i = 0; i < n; i++) {
+        if (values[i] == value) {
+            return i;
         }
-        (*end)--;
     }
+    return -1;
 }
 
-/* Free the allocated memory for the list */
-void deleteList(int* list) {
-    free(list);
+static int scalarCountEqual(const int* values, int n, int value) {
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        count += (values[i] == value);
+    }
+    return count;
+}
+
+static long long scalarSum(const int* values, int n) {
+    long long sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+static void scalarMinMax(const int* values, int n, int* min, int* max) {
+    int lo = values[0];
+    int hi = values[0];
+    for (int i = 1; i < n; i++) {
+        lo = (values[i] < lo) ? values[i] : lo;
+        hi = (values[i] > hi) ? values[i] : hi;
+    }
+    *min = lo;
+    *max = hi;
+}
+
+static int scalarFilter(const int* values, int n, int low, int high, int* dst) {
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        dst[count] = values[i];
+        count += (values[i] >= low && values[i] <= high);
+    }
+    return count;
+}
+
+static const listKernels scalarKernels = {
+    "scalar", scalarFindFirst, scalarCountEqual, scalarSum, scalarMinMax, scalarFilter
+};
+
+#ifdef HAVE_X86_KERNELS
+
+/* AVX2 kernels, 8 elements at a time. */
+__attribute__((target("avx2")))
+static int avx2FindFirst(const int* values, int n, int value) {
+    __m256i needle = _mm256_set1_epi32(value);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) &values[i]);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, needle)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+
+    int rest = scalarFindFirst(&values[i], n - i, value);
+    return (rest == -1) ? -1 : i + rest;
+}
+
+__attribute__((target("avx2")))
+static int avx2CountEqual(const int* values, int n, int value) {
+    __m256i needle = _mm256_set1_epi32(value);
+    __m256i counts = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        // matching lanes are -1, so subtracting adds one per match
+        __m256i v = _mm256_loadu_si256((const __m256i*) &values[i]);
+        counts = _mm256_sub_epi32(counts, _mm256_cmpeq_epi32(v, needle));
+    }
+
+    int lanes[8];
+    _mm256_storeu_si256((__m256i*) lanes, counts);
+    int count = scalarCountEqual(&values[i], n - i, value);
+    for (int j = 0; j < 8; j++) {
+        count += lanes[j];
+    }
+    return count;
+}
+
+__attribute__((target("avx2")))
+static long long avx2Sum(const int* values, int n) {
+    // widen to 64-bit lanes so the sum can't overflow
+    __m256i sumLow = _mm256_setzero_si256();
+    __m256i sumHigh = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) &values[i]);
+        sumLow = _mm256_add_epi64(sumLow, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        sumHigh = _mm256_add_epi64(sumHigh, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+
+    long long lanes[4];
+    _mm256_storeu_si256((__m256i*) lanes, _mm256_add_epi64(sumLow, sumHigh));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + scalarSum(&values[i], n - i);
+}
+
+__attribute__((target("avx2")))
+static void avx2MinMax(const int* values, int n, int* min, int* max) {
+    if (n < 8) {
+        scalarMinMax(values, n, min, max);
+        return;
+    }
+
+    __m256i lo = _mm256_loadu_si256((const __m256i*) values);
+    __m256i hi = lo;
+    int i = 8;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) &values[i]);
+        lo = _mm256_min_epi32(lo, v);
+        hi = _mm256_max_epi32(hi, v);
+    }
+
+    int loLanes[8], hiLanes[8];
+    _mm256_storeu_si256((__m256i*) loLanes, lo);
+    _mm256_storeu_si256((__m256i*) hiLanes, hi);
+    int resultMin = loLanes[0], resultMax = hiLanes[0];
+    for (int j = 1; j < 8; j++) {
+        resultMin = (loLanes[j] < resultMin) ? loLanes[j] : resultMin;
+        resultMax = (hiLanes[j] > resultMax) ? hiLanes[j] : resultMax;
+    }
+    for (; i < n; i++) {
+        resultMin = (values[i] < resultMin) ? values[i] : resultMin;
+        resultMax = (values[i] > resultMax) ? values[i] : resultMax;
+    }
+    *min = resultMin;
+    *max = resultMax;
+}
+
+/* For every 8-bit match mask, the lane indexes of the matches moved to
+   the front. Used by avx2Filter() to pack matches together. */
+static int avx2FilterTable[256][8];
+
+static void buildAvx2FilterTable(void) {
+    for (int mask = 0; mask < 256; mask++) {
+        int count = 0;
+        for (int lane = 0; lane < 8; lane++) {
+            if (mask & (1 << lane)) {
+                avx2FilterTable[mask][count++] = lane;
+            }
+        }
+        while (count < 8) {
+            avx2FilterTable[mask][count++] = 0;
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static int avx2Filter(const int* values, int n, int low, int high, int* dst) {
+    __m256i lowVec = _mm256_set1_epi32(low);
+    __m256i highVec = _mm256_set1_epi32(high);
+    int count = 0;
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) &values[i]);
+        __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(lowVec, v), _mm256_cmpgt_epi32(v, highVec));
+        int mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xff;
+
+        // all 8 lanes are stored, but 'count' only moves past the matches;
+        // count <= i so this never writes past dst[n - 1]
+        __m256i permutation = _mm256_loadu_si256((const __m256i*) avx2FilterTable[mask]);
+        _mm256_storeu_si256((__m256i*) &dst[count], _mm256_permutevar8x32_epi32(v, permutation));
+        count += __builtin_popcount(mask);
+    }
+
+    return count + scalarFilter(&values[i], n - i, low, high, &dst[count]);
+}
+
+static const listKernels avx2Kernels = {
+    "avx2", avx2FindFirst, avx2CountEqual, avx2Sum, avx2MinMax, avx2Filter
+};
+
+/* AVX-512 kernels, 16 elements at a time. */
+__attribute__((target("avx512f")))
+static int avx512FindFirst(const int* values, int n, int value) {
+    __m512i needle = _mm512_set1_epi32(value);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __mmask16 mask = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(&values[i]), needle);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+
+    int rest = scalarFindFirst(&values[i], n - i, value);
+    return (rest == -1) ? -1 : i + rest;
+}
+
+__attribute__((target("avx512f")))
+static int avx512CountEqual(const int* values, int n, int value) {
+    __m512i needle = _mm512_set1_epi32(value);
+    int count = 0;
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        count += __builtin_popcount(_mm512_cmpeq_epi32_mask(_mm512_loadu_si512(&values[i]), needle));
+    }
+    return count + scalarCountEqual(&values[i], n - i, value);
+}
+
+__attribute__((target("avx512f")))
+static long long avx512Sum(const int* values, int n) {
+    __m512i sumLow = _mm512_setzero_si512();
+    __m512i sumHigh = _mm512_setzero_si512();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(&values[i]);
+        sumLow = _mm512_add_epi64(sumLow, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+        sumHigh = _mm512_add_epi64(sumHigh, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+    }
+    return _mm512_reduce_add_epi64(_mm512_add_epi64(sumLow, sumHigh)) + scalarSum(&values[i], n - i);
+}
+
+__attribute__((target("avx512f")))
+static void avx512MinMax(const int* values, int n, int* min, int* max) {
+    if (n < 16) {
+        scalarMinMax(values, n, min, max);
+        return;
+    }
+
+    __m512i lo = _mm512_loadu_si512(values);
+    __m512i hi = lo;
+    int i = 16;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(&values[i]);
+        lo = _mm512_min_epi32(lo, v);
+        hi = _mm512_max_epi32(hi, v);
+    }
+
+    int resultMin = _mm512_reduce_min_epi32(lo);
+    int resultMax = _mm512_reduce_max_epi32(hi);
+    for (; i < n; i++) {
+        resultMin = (values[i] < resultMin) ? values[i] : resultMin;
+        resultMax = (values[i] > resultMax) ? values[i] : resultMax;
+    }
+    *min = resultMin;
+    *max = resultMax;
+}
+
+__attribute__((target("avx512f")))
+static int avx512Filter(const int* values, int n, int low, int high, int* dst) {
+    __m512i lowVec = _mm512_set1_epi32(low);
+    __m512i highVec = _mm512_set1_epi32(high);
+    int count = 0;
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(&values[i]);
+        __mmask16 mask = _mm512_cmpge_epi32_mask(v, lowVec) & _mm512_cmple_epi32_mask(v, highVec);
+
+        // only the matching lanes are written
+        _mm512_mask_compressstoreu_epi32(&dst[count], mask, v);
+        count += __builtin_popcount(mask);
+    }
+
+    return count + scalarFilter(&values[i], n - i, low, high, &dst[count]);
+}
+
+static const listKernels avx512Kernels = {
+    "avx512", avx512FindFirst, avx512CountEqual, avx512Sum, avx512MinMax, avx512Filter
+};
+
+#endif
+
+/* Kernels picked for this CPU by selectKernels() */
+static const listKernels* kernels = &scalarKernels;
+static pthread_once_t kernelsOnce = PTHREAD_ONCE_INIT;
+
+/* Pick the best kernels for this CPU. */
+static void selectKernels(void) {
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        kernels = &avx512Kernels;
+    }
+    else if (__builtin_cpu_supports("avx2")) {
+        buildAvx2FilterTable();
+        kernels = &avx2Kernels;
+    }
+#endif
+}
+
+/* Kernels for this CPU, picked the first time they are needed (only
+   once, even if lists are first used from several threads at once). */
+static const listKernels* getKernels(void) {
+    pthread_once(&kernelsOnce, selectKernels);
+    return kernels;
+}
+
+/* Find first element equal to value */
+int findFirst(dynamicList* list, int value) {
+    closeGap(list);
+    return getKernels()->findFirst(list->values, list->end + 1, value);
 }
+
+/* Count elements equal to value */
+int countEqual(dynamicList* list, int value) {
+    closeGap(list);
+    return getKernels()->countEqual(list->values, list->end + 1, value);
+}
+
+/* Sum of elements */
+long long sumList(dynamicList* list) {
+    closeGap(list);
+    return getKernels()->sum(list->values, list->end + 1);
+}
+
+/* Smallest and largest element */
+int minMaxList(dynamicList* list, int* min, int* max) {
+    closeGap(list);
+    if (list->end == -1) {
+        return 0;
+    }
+    getKernels()->minMax(list->values, list->end + 1, min, max);
+    return 1;
+}
+
+/* Copy elements in range to a new list */
+dynamicList* filterList(dynamicList* list, int low, int high) {
+    closeGap(list);
+
+    // every element could match
+    dynamicList* filtered = initializeListWithOptions(list->end + 1, list->growthFactor, list->useMremap);
+    if (filtered == NULL) {
+        return NULL;
+    }
+
+    int count = getKernels()->filter(list->values, list->end + 1, low, high, filtered->values);
+    filtered->end = count - 1;
+    filtered->gapStart = count;
+
+    return filtered;
+}
+
+/* Name of kernels in use */
+const char* listKernelName(void) {
+    return getKernels()->name;
+}
+
+/*
+__________________________________________________________________
+
+                            SORTING
+__________________________________________________________________
+
+*/
+
+/* Sort short array in place. */
+static inline void insertionSort(int* values, int n) {
+    for (int i = 1; i < n; i++) {
+        int value = values[i];
+        int j = i - 1;
+        while (j >= 0 && values[j] > value) {
+            values[j + 1] = values[j];
+            j--;
+        }
+        values[j + 1] = value;
+    }
+}
+
+/* LSD radix sort, one byte per pass, using 'temp' (room for 'n'
+   elements) as the second buffer. The result ends up in 'values'. */
+static void radixSort(int* values, int* temp, int n) {
+    if (n < INSERTION_SORT_THRESHOLD) {
+        insertionSort(values, n);
+        return;
+    }
+
+    // count all four digits in one pass; flipping the sign bit makes
+    // negative numbers sort before positive ones
+    static const unsigned int signBit = 0x80000000u;
+    int counts[4][256];
+    memset(counts, 0, sizeof(counts));
+    for (int i = 0; i < n; i++) {
+        unsigned int key = (unsigned int) values[i] ^ signBit;
+        counts[0][key & 0xff]++;
+        counts[1][(key >> 8) & 0xff]++;
+        counts[2][(key >> 16) & 0xff]++;
+        counts[3][key >> 24]++;
+    }
+
+    int* src = values;
+    int* dst = temp;
+    for (int pass = 0; pass < 4; pass++) {
+        int shift = pass * 8;
+
+        // skip pass if every element has the same digit
+        if (counts[pass][(((unsigned int) src[0] ^ signBit) >> shift) & 0xff] == n) {
+            continue;
+        }
+
+        // turn counts into starting positions
+        int offsets[256];
+        int total = 0;
+        for (int digit = 0; digit < 256; digit++) {
+            offsets[digit] = total;
+            total += counts[pass][digit];
+        }
+
+        for (int i = 0; i < n; i++) {
+            unsigned int digit = (((unsigned int) src[i] ^ signBit) >> shift) & 0xff;
+            dst[offsets[digit]++] = src[i];
+        }
+
+        int* swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    // odd number of passes leaves the result in 'temp'
+    if (src != values) {
+        memcpy(values, src, (size_t) n * sizeof(int));
+    }
+}
+
+/* Merge sorted runs [a, a + lengthA) and [b, b + lengthB) into 'dst'. */
+static void mergeRuns(const int* a, int lengthA, const int* b, int lengthB, int* dst) {
+    int i = 0, j = 0, k = 0;
+    while (i < lengthA && j < lengthB) {
+        dst[k++] = (b[j] < a[i]) ? b[j++] : a[i++];
+    }
+    memcpy(&dst[k], &a[i], (size_t) (lengthA - i) * sizeof(int));
+    k += lengthA - i;
+    memcpy(&dst[k], &b[j], (size_t) (lengthB - j) * sizeof(int));
+}
+
+/* State shared by the sorting threads. */
+struct sortJob {
+    int* values;
+    int* temp;
+    int n;
+    int numThreads;
+    pthread_barrier_t barrier;
+
+    // held by sortList() until all threads are started, so that
+    // 'numThreads' and 'barrier' are final before threads use them
+    pthread_mutex_t start;
+} typedef sortJob;
+
+/* Arguments for one sorting thread. */
+struct sortWorker {
+    sortJob* job;
+    int id;
+} typedef sortWorker;
+
+/* Start of the part of the array owned by thread 'id'. */
+static int partStart(sortJob* job, int id) {
+    return (int) ((long long) job->n * id / job->numThreads);
+}
+
+/*
+    Each thread radix sorts its own part of the array. Then in every
+    round, threads whose id is a multiple of (2 * width) merge their run
+    with the run 'width' threads over, until one run is left. Runs are
+    merged back and forth between 'values' and 'temp'.
+*/
+static void* sortThread(void* arg) {
+    sortWorker* worker = (sortWorker*) arg;
+    sortJob* job = worker->job;
+    int id = worker->id;
+
+    pthread_mutex_lock(&job->start);
+    pthread_mutex_unlock(&job->start);
+
+    int start = partStart(job, id);
+    int end = partStart(job, id + 1);
+    radixSort(&job->values[start], &job->temp[start], end - start);
+
+    int* src = job->values;
+    int* dst = job->temp;
+    for (int width = 1; width < job->numThreads; width *= 2) {
+        pthread_barrier_wait(&job->barrier);
+
+        if (id % (2 * width) == 0) {
+            int middle = partStart(job, (id + width < job->numThreads) ? id + width : job->numThreads);
+            int last = partStart(job, (id + 2 * width < job->numThreads) ? id + 2 * width : job->numThreads);
+            mergeRuns(&src[start], middle - start, &src[middle], last - middle, &dst[start]);
+        }
+
+        int* swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    return NULL;
+}
+
+/* Sort list */
+int sortList(dynamicList* list, int numThreads) {
+    closeGap(list);
+    int n = list->end + 1;
+
+    if (n < INSERTION_SORT_THRESHOLD) {
+        insertionSort(list->values, n);
+        return 1;
+    }
+
+    int* temp = (int*) malloc((size_t) n * sizeof(int));
+    if (temp == NULL) {
+        return 0;
+    }
+
+    if (numThreads <= 0) {
+        numThreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (numThreads > MAX_SORT_THREADS) {
+        numThreads = MAX_SORT_THREADS;
+    }
+
+    if (n < PARALLEL_SORT_THRESHOLD || numThreads <= 1) {
+        radixSort(list->values, temp, n);
+        free(temp);
+        return 1;
+    }
+
+    sortJob job;
+    job.values = list->values;
+    job.temp = temp;
+    job.n = n;
+    pthread_mutex_init(&job.start, NULL);
+    pthread_mutex_lock(&job.start);
+
+    // this thread works as thread 0
+    pthread_t threads[MAX_SORT_THREADS];
+    sortWorker workers[MAX_SORT_THREADS];
+    for (int t = 0; t < numThreads; t++) {
+        workers[t].job = &job;
+        workers[t].id = t;
+    }
+    int started = 1;
+    while (started < numThreads &&
+           pthread_create(&threads[started], NULL, sortThread, &workers[started]) == 0) {
+        started++;
+    }
+
+    // carry on with the threads that could be started (just this one
+    // makes it a serial sort)
+    numThreads = started;
+    job.numThreads = numThreads;
+    pthread_barrier_init(&job.barrier, NULL, (unsigned int) numThreads);
+    pthread_mutex_unlock(&job.start);
+
+    sortThread(&workers[0]);
+    for (int t = 1; t < numThreads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    pthread_barrier_destroy(&job.barrier);
+    pthread_mutex_destroy(&job.start);
+
+    // every merge round swaps buffers, an odd number of rounds leaves
+    // the result in 'temp'
+    int rounds = 0;
+    for (int width = 1; width < numThreads; width *= 2) {
+        rounds++;
+    }
+    if (rounds % 2 == 1) {
+        memcpy(list->values, temp, (size_t) n * sizeof(int));
+    }
+
+    free(temp);
+    return 1;
+}
+
+/*
+__________________________________________________________________
+
+                            BENCHMARKS
+__________________________________________________________________
+
+*/
+
+#ifdef BENCHMARK
+
+#ifndef BENCHMARK_ELEMENTS
+#define BENCHMARK_ELEMENTS (50000000)
+#endif
+
+/* Seconds between two timestamps. */
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/* Append BENCHMARK_ELEMENTS values in a child process so that the peak
+   memory reported is for this run only. */
+static void runPushBack(double growthFactor, int useMremap) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        struct timespec start, end;
+        dynamicList* list = initializeListWithOptions(DEFAULT_CAPACITY, growthFactor, useMremap);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < BENCHMARK_ELEMENTS; i++) {
+            insertElement(list, i);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        printf("  growth %.2f %-10s %6.2f ns/push, peak RSS %7.1f MiB (data %7.1f MiB)\n",
+               growthFactor, useMremap ? "mremap" : "realloc",
+               elapsedSeconds(start, end) / BENCHMARK_ELEMENTS * 1e9,
+               usage.ru_maxrss / 1024.0,
+               (double) BENCHMARK_ELEMENTS * sizeof(int) / (1 << 20));
+
+        deleteList(list);
+        exit(EXIT_SUCCESS);
+    }
+    waitpid(pid, NULL, 0);
+}
+
+/* Run push-back benchmarks. */
+void benchmarkPushBack(void) {
+    printf("\nPush back of %d elements\n", BENCHMARK_ELEMENTS);
+
+    double factors[] = { 1.25, 1.5, 2.0 };
+    for (int i = 0; i < 3; i++) {
+        runPushBack(factors[i], 0);
+        runPushBack(factors[i], 1);
+    }
+}
+
+#ifndef BENCHMARK_KERNEL_ELEMENTS
+#define BENCHMARK_KERNEL_ELEMENTS (16000000)
+#endif
+
+#ifndef BENCHMARK_KERNEL_REPEATS
+#define BENCHMARK_KERNEL_REPEATS (20)
+#endif
+
+/* Time each kernel of a set over the benchmark array. */
+static void runKernels(const listKernels* kernels, const int* values, int* dst) {
+    struct timespec start, end;
+    int n = BENCHMARK_KERNEL_ELEMENTS;
+    double gigabytes = (double) n * sizeof(int) * BENCHMARK_KERNEL_REPEATS / 1e9;
+    long long check = 0;
+    int min, max;
+
+    printf("  %s\n", kernels->name);
+
+    // look for a value that isn't there so the whole array is scanned
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCHMARK_KERNEL_REPEATS; r++) {
+        check += kernels->findFirst(values, n, -1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("    find    %6.2f GB/s (%lld)\n", gigabytes / elapsedSeconds(start, end), check);
+
+    check = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCHMARK_KERNEL_REPEATS; r++) {
+        check += kernels->countEqual(values, n, r);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("    count   %6.2f GB/s (%lld)\n", gigabytes / elapsedSeconds(start, end), check);
+
+    check = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCHMARK_KERNEL_REPEATS; r++) {
+        check += kernels->sum(values, n);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("    sum     %6.2f GB/s (%lld)\n", gigabytes / elapsedSeconds(start, end), check);
+
+    check = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCHMARK_KERNEL_REPEATS; r++) {
+        kernels->minMax(values, n, &min, &max);
+        check += min + max;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("    minmax  %6.2f GB/s (%lld)\n", gigabytes / elapsedSeconds(start, end), check);
+
+    check = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCHMARK_KERNEL_REPEATS; r++) {
+        check += kernels->filter(values, n, 0, 499, dst);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("    filter  %6.2f GB/s (%lld)\n", gigabytes / elapsedSeconds(start, end), check);
+}
+
+#ifndef BENCHMARK_LIST_LENGTH
+#define BENCHMARK_LIST_LENGTH (2000000)
+#endif
+
+#ifndef BENCHMARK_EDITS
+#define BENCHMARK_EDITS (4000)
+#endif
+
+/* Insert and delete around a cursor that drifts through the list, then
+   at random positions. */
+static void runMiddleEdits(int useGapBuffer) {
+    struct timespec start, end;
+    dynamicList* list = initializeList(DEFAULT_CAPACITY);
+    for (int i = 0; i < BENCHMARK_LIST_LENGTH; i++) {
+        insertElement(list, i);
+    }
+    setGapBuffer(list, useGapBuffer);
+
+    srand(1);
+    int cursor = BENCHMARK_LIST_LENGTH / 2;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCHMARK_EDITS; i++) {
+        cursor += rand() % 64 - 32;
+        insertElement(list, i, cursor);
+        deleteElement(list, cursor + 1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double clustered = elapsedSeconds(start, end) / (2.0 * BENCHMARK_EDITS) * 1e9;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCHMARK_EDITS; i++) {
+        int index = rand() % BENCHMARK_LIST_LENGTH;
+        insertElement(list, i, index);
+        deleteElement(list, index + 1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double random = elapsedSeconds(start, end) / (2.0 * BENCHMARK_EDITS) * 1e9;
+
+    printf("  %-8s clustered %10.1f ns/edit, random %10.1f ns/edit\n",
+           useGapBuffer ? "gap" : "memmove", clustered, random);
+
+    deleteList(list);
+}
+
+/* Run middle edit benchmarks. */
+void benchmarkMiddleEdits(void) {
+    printf("\nMiddle inserts/deletes on a list of %d elements\n", BENCHMARK_LIST_LENGTH);
+    runMiddleEdits(0);
+    runMiddleEdits(1);
+}
+
+#ifndef BENCHMARK_SORT_ELEMENTS
+#define BENCHMARK_SORT_ELEMENTS (10000000)
+#endif
+
+/* Compare ints for qsort(). */
+static int compareInts(const void* a, const void* b) {
+    int x = *(const int*) a;
+    int y = *(const int*) b;
+    return (x > y) - (x < y);
+}
+
+/* Fill list with the same random numbers every time. */
+static void fillRandom(dynamicList* list, int n) {
+    srand(1);
+    eraseRange(list, 0, list->end + 1);
+    for (int i = 0; i < n; i++) {
+        insertElement(list, rand() - RAND_MAX / 2);
+    }
+}
+
+/* Run sort benchmarks. */
+void benchmarkSort(void) {
+    struct timespec start, end;
+    int n = BENCHMARK_SORT_ELEMENTS;
+    dynamicList* list = initializeList(n);
+
+    printf("\nSorting %d random integers\n", n);
+
+    fillRandom(list, n);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    qsort(list->values, n, sizeof(int), compareInts);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  %-19s %8.3f s\n", "qsort", elapsedSeconds(start, end));
+
+    int threadCounts[] = { 1, 0 };
+    for (int i = 0; i < 2; i++) {
+        fillRandom(list, n);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        sortList(list, threadCounts[i]);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        int sorted = 1;
+        for (int j = 1; j < n; j++) {
+            sorted &= (list->values[j - 1] <= list->values[j]);
+        }
+        printf("  %-19s %8.3f s%s\n", threadCounts[i] ? "sortList (1 thread)" : "sortList (all CPUs)",
+               elapsedSeconds(start, end), sorted ? "" : " NOT SORTED");
+    }
+
+    deleteList(list);
+}
+
+/* Run kernel benchmarks. */
+void benchmarkKernels(void) {
+    int n = BENCHMARK_KERNEL_ELEMENTS;
+    int* values = (int*) malloc(n * sizeof(int));
+    int* dst = (int*) malloc(n * sizeof(int));
+    if (values == NULL || dst == NULL) {
+        printf("Not enough memory. Line %d\n", __LINE__);
+        exit(EXIT_FAILURE);
+    }
+
+    srand(1);
+    for (int i = 0; i < n; i++) {
+        values[i] = rand() % 1000;
+    }
+
+    printf("\nScan/reduce over %d elements\n", n);
+    runKernels(&scalarKernels, values, dst);
+    if (getKernels() != &scalarKernels) {
+        runKernels(getKernels(), values, dst);
+    }
+#ifdef HAVE_X86_KERNELS
+    if (getKernels() == &avx512Kernels) {
+        buildAvx2FilterTable();
+        runKernels(&avx2Kernels, values, dst);
+    }
+#endif
+
+    free(values);
+    free(dst);
+}
+
+#endif
@@ -0,0 +1,306 @@
+/** @file   generic_containers.c
+ *  @brief  Examples of the type-specialized containers generated by the
+ *          macros in generic_containers.h.
+ *          Compile with -DBENCHMARK to compare them against containers
+ *          that store a pointer to each element, for elements of 8, 16,
+ *          64 and 256 bytes.
+ */
+
+#define _POSIX_C_SOURCE 200809L     // clock_gettime()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef BENCHMARK
+#include <time.h>                   // clock_gettime()
+#endif
+
+#include "generic_containers.h"
+
+/* Comparison and hashing for int keys, expanded inline by the macros */
+#define compareInts(a, b) (((a) > (b)) - ((a) < (b)))
+#define hashInt(key) ((size_t) (key) * 0x9e3779b97f4a7c15ULL >> 16)
+#define equalInts(a, b) ((a) == (b))
+
+DEFINE_VECTOR(intVector, int)
+DEFINE_QUEUE(intQueue, int)
+DEFINE_BST(intTree, int, const char*, compareInts)
+DEFINE_HASHMAP(intMap, int, int, hashInt, equalInts)
+
+/*
+__________________________________________________________________
+
+                        FUNCTION DECLARATIONS
+__________________________________________________________________
+
+*/
+
+#ifdef BENCHMARK
+/*
+    Vector, queue and tree operations on elements of 8, 16, 64 and 256
+    bytes stored inline vs stored as pointers to separately allocated
+    elements with a comparison function pointer.
+*/
+void benchmarkContainers(void);
+#endif
+
+/*
+__________________________________________________________________
+
+                                MAIN
+__________________________________________________________________
+
+*/
+
+int main(void) {
+    // vector
+    intVector vector;
+    intVectorInit(&vector);
+    for (int i = 0; i < 10; i++) {
+        intVectorPush(&vector, (i + 1));
+    }
+    int last = intVectorPop(&vector);
+    printf("Vector: popped %d, %zu elements left, [3] = %d\n", last,
+           vector.length, *intVectorAt(&vector, 3));
+    intVectorFree(&vector);
+
+    // queue
+    intQueue queue;
+    intQueueInit(&queue);
+    int value;
+    for (int i = 0; i < 20; i++) {
+        intQueueEnqueue(&queue, (i + 1));
+        if (i % 3 == 0) {
+            intQueueDequeue(&queue, &value);
+        }
+    }
+    printf("Queue:");
+    while (intQueueDequeue(&queue, &value)) {
+        printf(" %d", value);
+    }
+    printf("\n");
+    intQueueFree(&queue);
+
+    // binary search tree
+    intTree tree;
+    intTreeInit(&tree);
+    intTreeInsert(&tree, 4, "four");
+    intTreeInsert(&tree, 1, "one");
+    intTreeInsert(&tree, 7, "seven");
+    intTreeInsert(&tree, 1, "uno");
+    const char** name = intTreeFind(&tree, 1);
+    printf("Tree: %zu keys, 1 -> %s, 5 -> %s\n", tree.size,
+           name ? *name : "(none)", intTreeFind(&tree, 5) ? "found" : "(none)");
+    intTreeFree(&tree);
+
+    // hash map
+    intMap map;
+    intMapInit(&map);
+    for (int i = 0; i < 100; i++) {
+        intMapPut(&map, i, i * i);
+    }
+    intMapRemove(&map, 50);
+    printf("Map: %zu keys, 9 -> %d, 50 -> %s\n", map.size, *intMapGet(&map, 9),
+           intMapGet(&map, 50) ? "found" : "(none)");
+    intMapFree(&map);
+
+    #ifdef BENCHMARK
+        benchmarkContainers();
+    #endif
+
+    return 0;
+}
+
+/*
+__________________________________________________________________
+
+                            BENCHMARKS
+__________________________________________________________________
+
+*/
+
+#ifdef BENCHMARK
+
+/* Total element bytes per run, the element count depends on the size */
+#ifndef BENCHMARK_BYTES
+#define BENCHMARK_BYTES (64 << 20)
+#endif
+
+/* Elements per tree run */
+#ifndef BENCHMARK_TREE_ELEMENTS
+#define BENCHMARK_TREE_ELEMENTS (500000)
+#endif
+
+/* Seconds between two timestamps. */
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/* Pseudo-random tree keys, the same for every run. */
+static long long treeKey(long long i) {
+    return (i * 2654435761LL) % 1000000007LL;
+}
+
+/* Pointer-based containers: every element is allocated on its own and
+   keys are compared through a function pointer. */
+static int compareBoxedKeys(const void* a, const void* b) {
+    long long x = *(const long long*) a;
+    long long y = *(const long long*) b;
+    return (x > y) - (x < y);
+}
+static int (*boxedCompare)(const void*, const void*) = compareBoxedKeys;
+#define callBoxedCompare(a, b) boxedCompare(a, b)
+
+DEFINE_VECTOR(boxedVector, void*)
+DEFINE_QUEUE(boxedQueue, void*)
+DEFINE_BST(boxedTree, void*, void*, callBoxedCompare)
+
+#define compareKeys(a, b) (((a) > (b)) - ((a) < (b)))
+
+/*
+    Define element type of S bytes (key in the first word), inline
+    containers for it and a function that times both kinds of container.
+*/
+#define DEFINE_ELEMENT_BENCHMARK(S)                                             \
+struct element##S {                                                             \
+    long long words[S / sizeof(long long)];                                     \
+} typedef element##S;                                                           \
+                                                                                \
+DEFINE_VECTOR(element##S##Vector, element##S)                                   \
+DEFINE_QUEUE(element##S##Queue, element##S)                                     \
+DEFINE_BST(element##S##Tree, long long, element##S, compareKeys)                \
+                                                                                \
+static void benchmarkElement##S(void) {                                         \
+    struct timespec start, end;                                                 \
+    long n = BENCHMARK_BYTES / S;                                               \
+    long long check = 0;                                                        \
+    element##S element;                                                         \
+    memset(&element, 0, sizeof(element));                                       \
+                                                                                \
+    /* vector: push all, then scan */                                           \
+    clock_gettime(CLOCK_MONOTONIC, &start);                                     \
+    element##S##Vector vector;                                                  \
+    element##S##VectorInit(&vector);                                            \
+    for (long i = 0; i < n; i++) {                                              \
+        element.words[0] = i;                                                   \
+        element##S##VectorPush(&vector, element);                               \
+    }                                                                           \
+    for (long i = 0; i < n; i++) {                                              \
+        check += element##S##VectorAt(&vector, i)->words[0];                    \
+    }                                                                           \
+    element##S##VectorFree(&vector);                                            \
+    clock_gettime(CLOCK_MONOTONIC, &end);                                       \
+    double inlineVector = elapsedSeconds(start, end) / n * 1e9;                 \
+                                                                                \
+    clock_gettime(CLOCK_MONOTONIC, &start);                                     \
+    boxedVector boxed;                                                          \
+    boxedVectorInit(&boxed);                                                    \
+    for (long i = 0; i < n; i++) {                                              \
+        element##S* copy = (element##S*) malloc(sizeof(element##S));            \
+        *copy = element;                                                        \
+        copy->words[0] = i;                                                     \
+        boxedVectorPush(&boxed, copy);                                          \
+    }                                                                           \
+    for (long i = 0; i < n; i++) {                                              \
+        check -= ((element##S*) *boxedVectorAt(&boxed, i))->words[0];           \
+    }                                                                           \
+    for (long i = 0; i < n; i++) {                                              \
+        free(*boxedVectorAt(&boxed, i));                                        \
+    }                                                                           \
+    boxedVectorFree(&boxed);                                                    \
+    clock_gettime(CLOCK_MONOTONIC, &end);                                       \
+    double boxedVectorTime = elapsedSeconds(start, end) / n * 1e9;              \
+                                                                                \
+    /* queue: enqueue all, then dequeue all */                                  \
+    clock_gettime(CLOCK_MONOTONIC, &start);                                     \
+    element##S##Queue queue;                                                    \
+    element##S##QueueInit(&queue);                                              \
+    for (long i = 0; i < n; i++) {                                              \
+        element.words[0] = i;                                                   \
+        element##S##QueueEnqueue(&queue, element);                              \
+    }                                                                           \
+    while (element##S##QueueDequeue(&queue, &element)) {                        \
+        check += element.words[0];                                              \
+    }                                                                           \
+    element##S##QueueFree(&queue);                                              \
+    clock_gettime(CLOCK_MONOTONIC, &end);                                       \
+    double inlineQueue = elapsedSeconds(start, end) / n * 1e9;                  \
+                                                                                \
+    clock_gettime(CLOCK_MONOTONIC, &start);                                     \
+    boxedQueue boxedQ;                                                          \
+    boxedQueueInit(&boxedQ);                                                    \
+    for (long i = 0; i < n; i++) {                                              \
+        element##S* copy = (element##S*) malloc(sizeof(element##S));            \
+        *copy = element;                                                        \
+        copy->words[0] = i;                                                     \
+        boxedQueueEnqueue(&boxedQ, copy);                                       \
+    }                                                                           \
+    void* pointer;                                                              \
+    while (boxedQueueDequeue(&boxedQ, &pointer)) {                              \
+        check -= ((element##S*) pointer)->words[0];                             \
+        free(pointer);                                                          \
+    }                                                                           \
+    boxedQueueFree(&boxedQ);                                                    \
+    clock_gettime(CLOCK_MONOTONIC, &end);                                       \
+    double boxedQueueTime = elapsedSeconds(start, end) / n * 1e9;               \
+                                                                                \
+    /* tree: insert random keys, then look all of them up */                    \
+    long treeN = BENCHMARK_TREE_ELEMENTS;                                       \
+    clock_gettime(CLOCK_MONOTONIC, &start);                                     \
+    element##S##Tree tree;                                                      \
+    element##S##TreeInit(&tree);                                                \
+    for (long i = 0; i < treeN; i++) {                                          \
+        element.words[0] = treeKey(i);                                          \
+        element##S##TreeInsert(&tree, element.words[0], element);               \
+    }                                                                           \
+    for (long i = 0; i < treeN; i++) {                                          \
+        check += element##S##TreeFind(&tree, treeKey(i))->words[0];             \
+    }                                                                           \
+    element##S##TreeFree(&tree);                                                \
+    clock_gettime(CLOCK_MONOTONIC, &end);                                       \
+    double inlineTree = elapsedSeconds(start, end) / treeN * 1e9;               \
+                                                                                \
+    clock_gettime(CLOCK_MONOTONIC, &start);                                     \
+    boxedTree boxedT;                                                           \
+    boxedTreeInit(&boxedT);                                                     \
+    element##S** copies = (element##S**) malloc(treeN * sizeof(element##S*));   \
+    for (long i = 0; i < treeN; i++) {                                          \
+        copies[i] = (element##S*) malloc(sizeof(element##S));                   \
+        *copies[i] = element;                                                   \
+        copies[i]->words[0] = treeKey(i);                                       \
+        boxedTreeInsert(&boxedT, copies[i], copies[i]);                         \
+    }                                                                           \
+    for (long i = 0; i < treeN; i++) {                                          \
+        long long key = treeKey(i);                                             \
+        check -= ((element##S*) *boxedTreeFind(&boxedT, &key))->words[0];       \
+    }                                                                           \
+    boxedTreeFree(&boxedT);                                                     \
+    for (long i = 0; i < treeN; i++) {                                          \
+        free(copies[i]);                                                        \
+    }                                                                           \
+    free(copies);                                                               \
+    clock_gettime(CLOCK_MONOTONIC, &end);                                       \
+    double boxedTreeTime = elapsedSeconds(start, end) / treeN * 1e9;            \
+                                                                                \
+    printf("  %3d bytes  vector %7.2f / %7.2f  queue %7.2f / %7.2f  "            \
+           "tree %7.1f / %7.1f  (check %lld)\n", S,                             \
+           inlineVector, boxedVectorTime, inlineQueue, boxedQueueTime,          \
+           inlineTree, boxedTreeTime, check);                                   \
+}
+
+DEFINE_ELEMENT_BENCHMARK(8)
+DEFINE_ELEMENT_BENCHMARK(16)
+DEFINE_ELEMENT_BENCHMARK(64)
+DEFINE_ELEMENT_BENCHMARK(256)
+
+/* Run container benchmarks. */
+void benchmarkContainers(void) {
+    printf("\nInline / pointer-based, ns per element (check should be 0)\n");
+    benchmarkElement8();
+    benchmarkElement16();
+    benchmarkElement64();
+    benchmarkElement256();
+}
+
+#endif
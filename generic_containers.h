@@ -0,0 +1,353 @@
+/** @file   generic_containers.h
+ *  @brief  Macros that generate containers specialized for one element
+ *          type. Elements are stored inline (no pointer and allocation
+ *          per element) and the compare/hash functions are called
+ *          directly so the compiler can inline them.
+ *          Every macro takes the name of the type to generate, which is
+ *          also the prefix of its functions, e.g. DEFINE_VECTOR(intVector, int)
+ *          generates 'intVector', 'intVectorPush()', ...
+ */
+
+#ifndef GENERIC_CONTAINERS_H
+#define GENERIC_CONTAINERS_H
+
+#include <stdlib.h>
+#include <string.h>                 // memcpy()
+#include <assert.h>
+
+/*
+__________________________________________________________________
+
+                            VECTOR
+__________________________________________________________________
+
+*/
+
+/*
+    DEFINE_VECTOR(Name, T)
+    Growable array of T. Generates:
+    -   Name                            struct with 'values', 'length', 'capacity'
+    -   void Name##Init(Name* vector)
+    -   void Name##Push(Name* vector, T value)
+    -   T    Name##Pop(Name* vector)    vector must not be empty
+    -   T*   Name##At(Name* vector, size_t index)
+    -   void Name##Free(Name* vector)
+*/
+#define DEFINE_VECTOR(Name, T)                                                  \
+struct Name {                                                                   \
+    T* values;                                                                  \
+    size_t length;                                                              \
+    size_t capacity;                                                            \
+} typedef Name;                                                                 \
+                                                                                \
+static inline void Name##Init(Name* vector) {                                   \
+    vector->values = NULL;                                                      \
+    vector->length = 0;                                                         \
+    vector->capacity = 0;                                                       \
+}                                                                               \
+                                                                                \
+static inline void Name##Push(Name* vector, T value) {                          \
+    /* double capacity when full */                                             \
+    if (vector->length == vector->capacity) {                                   \
+        vector->capacity = (vector->capacity == 0) ? 8 : vector->capacity * 2;  \
+        vector->values = (T*) realloc(vector->values, vector->capacity * sizeof(T)); \
+        assert(vector->values);                                                 \
+    }                                                                           \
+    vector->values[vector->length++] = value;                                   \
+}                                                                               \
+                                                                                \
+static inline T Name##Pop(Name* vector) {                                       \
+    assert(vector->length > 0);                                                 \
+    return vector->values[--vector->length];                                    \
+}                                                                               \
+                                                                                \
+static inline T* Name##At(Name* vector, size_t index) {                         \
+    return &vector->values[index];                                              \
+}                                                                               \
+                                                                                \
+static inline void Name##Free(Name* vector) {                                   \
+    free(vector->values);                                                       \
+    Name##Init(vector);                                                         \
+}
+
+/*
+__________________________________________________________________
+
+                            QUEUE
+__________________________________________________________________
+
+*/
+
+/*
+    DEFINE_QUEUE(Name, T)
+    FIFO queue of T stored in a circular array that doubles in size when
+    full. Generates:
+    -   Name                            struct with 'values', 'head', 'length', 'capacity'
+    -   void Name##Init(Name* queue)
+    -   void Name##Enqueue(Name* queue, T value)
+    -   int  Name##Dequeue(Name* queue, T* value)   returns 0 if queue is empty
+    -   void Name##Free(Name* queue)
+*/
+#define DEFINE_QUEUE(Name, T)                                                   \
+struct Name {                                                                   \
+    T* values;                                                                  \
+    size_t head;                                                                \
+    size_t length;                                                              \
+    size_t capacity;                                                            \
+} typedef Name;                                                                 \
+                                                                                \
+static inline void Name##Init(Name* queue) {                                    \
+    queue->values = NULL;                                                       \
+    queue->head = 0;                                                            \
+    queue->length = 0;                                                          \
+    queue->capacity = 0;                                                        \
+}                                                                               \
+                                                                                \
+static inline void Name##Enqueue(Name* queue, T value) {                        \
+    /* double capacity when full, moving the wrapped part after the rest */     \
+    if (queue->length == queue->capacity) {                                     \
+        size_t oldCapacity = queue->capacity;                                   \
+        queue->capacity = (oldCapacity == 0) ? 8 : oldCapacity * 2;             \
+        queue->values = (T*) realloc(queue->values, queue->capacity * sizeof(T)); \
+        assert(queue->values);                                                  \
+        memcpy(&queue->values[oldCapacity], queue->values, queue->head * sizeof(T)); \
+    }                                                                           \
+    size_t tail = (queue->head + queue->length) & (queue->capacity - 1);        \
+    queue->values[tail] = value;                                                \
+    queue->length++;                                                            \
+}                                                                               \
+                                                                                \
+static inline int Name##Dequeue(Name* queue, T* value) {                        \
+    if (queue->length == 0) {                                                   \
+        return 0;                                                               \
+    }                                                                           \
+    *value = queue->values[queue->head];                                        \
+    queue->head = (queue->head + 1) & (queue->capacity - 1);                    \
+    queue->length--;                                                            \
+    return 1;                                                                   \
+}                                                                               \
+                                                                                \
+static inline void Name##Free(Name* queue) {                                    \
+    free(queue->values);                                                        \
+    Name##Init(queue);                                                          \
+}
+
+/*
+__________________________________________________________________
+
+                        BINARY SEARCH TREE
+__________________________________________________________________
+
+*/
+
+/*
+    DEFINE_BST(Name, K, V, cmp)
+    Binary search tree mapping keys K to values V, ordered by 'cmp', a
+    function or macro taking two keys and returning <0, 0 or >0 like
+    strcmp(). Not balanced. Generates:
+    -   Name, Name##Node                struct with 'root' and 'size'
+    -   void Name##Init(Name* tree)
+    -   void Name##Insert(Name* tree, K key, V value)   replaces the value of an existing key
+    -   V*   Name##Find(Name* tree, K key)              NULL if key isn't in tree
+    -   void Name##Free(Name* tree)
+*/
+#define DEFINE_BST(Name, K, V, cmp)                                             \
+struct Name##Node {                                                             \
+    K key;                                                                      \
+    V value;                                                                    \
+    struct Name##Node* left;                                                    \
+    struct Name##Node* right;                                                   \
+} typedef Name##Node;                                                           \
+                                                                                \
+struct Name {                                                                   \
+    Name##Node* root;                                                           \
+    size_t size;                                                                \
+} typedef Name;                                                                 \
+                                                                                \
+static inline void Name##Init(Name* tree) {                                     \
+    tree->root = NULL;                                                          \
+    tree->size = 0;                                                             \
+}                                                                               \
+                                                                                \
+static inline void Name##Insert(Name* tree, K key, V value) {                   \
+    /* walk down to the link the new node goes into */                          \
+    Name##Node** link = &tree->root;                                            \
+    while (*link != NULL) {                                                     \
+        int order = cmp(key, (*link)->key);                                     \
+        if (order == 0) {                                                       \
+            (*link)->value = value;                                             \
+            return;                                                             \
+        }                                                                       \
+        link = (order < 0) ? &(*link)->left : &(*link)->right;                  \
+    }                                                                           \
+                                                                                \
+    Name##Node* node = (Name##Node*) malloc(sizeof(Name##Node));                \
+    assert(node);                                                               \
+    node->key = key;                                                            \
+    node->value = value;                                                        \
+    node->left = NULL;                                                          \
+    node->right = NULL;                                                         \
+    *link = node;                                                               \
+    tree->size++;                                                               \
+}                                                                               \
+                                                                                \
+static inline V* Name##Find(Name* tree, K key) {                                \
+    Name##Node* node = tree->root;                                              \
+    while (node != NULL) {                                                      \
+        int order = cmp(key, node->key);                                        \
+        if (order == 0) {                                                       \
+            return &node->value;                                                \
+        }                                                                       \
+        node = (order < 0) ? node->left : node->right;                          \
+    }                                                                           \
+    return NULL;                                                                \
+}                                                                               \
+                                                                                \
+static inline void Name##Free(Name* tree) {                                     \
+    /* rotate left children up until there are none, then free and go */       \
+    /* right; no recursion so deep (unbalanced) trees are fine */               \
+    Name##Node* node = tree->root;                                              \
+    while (node != NULL) {                                                      \
+        if (node->left != NULL) {                                               \
+            Name##Node* left = node->left;                                      \
+            node->left = left->right;                                           \
+            left->right = node;                                                 \
+            node = left;                                                        \
+        }                                                                       \
+        else {                                                                  \
+            Name##Node* right = node->right;                                    \
+            free(node);                                                         \
+            node = right;                                                       \
+        }                                                                       \
+    }                                                                           \
+    Name##Init(tree);                                                           \
+}
+
+/*
+__________________________________________________________________
+
+                            HASH MAP
+__________________________________________________________________
+
+*/
+
+/*
+    DEFINE_HASHMAP(Name, K, V, hash, equal)
+    Hash map from K to V using open addressing with linear probing.
+    'hash' takes a key and returns a size_t, 'equal' takes two keys and
+    returns non-zero if they are equal. Grows when half full.
+    Generates:
+    -   Name                            struct with 'keys', 'values', 'used', 'size', 'capacity'
+    -   void Name##Init(Name* map)
+    -   void Name##Put(Name* map, K key, V value)   replaces the value of an existing key
+    -   V*   Name##Get(Name* map, K key)            NULL if key isn't in map
+    -   int  Name##Remove(Name* map, K key)         returns 0 if key isn't in map
+    -   void Name##Free(Name* map)
+*/
+#define DEFINE_HASHMAP(Name, K, V, hash, equal)                                 \
+struct Name {                                                                   \
+    K* keys;                                                                    \
+    V* values;                                                                  \
+    unsigned char* used;                                                        \
+    size_t size;                                                                \
+    size_t capacity;                                                            \
+} typedef Name;                                                                 \
+                                                                                \
+static inline void Name##Init(Name* map) {                                      \
+    map->keys = NULL;                                                           \
+    map->values = NULL;                                                         \
+    map->used = NULL;                                                           \
+    map->size = 0;                                                              \
+    map->capacity = 0;                                                          \
+}                                                                               \
+                                                                                \
+/* Slot holding 'key', or the empty slot where it would go. */                  \
+static inline size_t Name##Slot(Name* map, K key) {                             \
+    size_t mask = map->capacity - 1;                                            \
+    size_t slot = hash(key) & mask;                                             \
+    while (map->used[slot] && !equal(map->keys[slot], key)) {                   \
+        slot = (slot + 1) & mask;                                               \
+    }                                                                           \
+    return slot;                                                                \
+}                                                                               \
+                                                                                \
+static inline void Name##Put(Name* map, K key, V value);                        \
+                                                                                \
+static inline void Name##Grow(Name* map) {                                      \
+    Name old = *map;                                                            \
+    map->capacity = (old.capacity == 0) ? 16 : old.capacity * 2;                \
+    map->keys = (K*) malloc(map->capacity * sizeof(K));                         \
+    map->values = (V*) malloc(map->capacity * sizeof(V));                      \
+    map->used = (unsigned char*) calloc(map->capacity, 1);                      \
+    assert(map->keys && map->values && map->used);                              \
+    map->size = 0;                                                              \
+    for (size_t i = 0; i < old.capacity; i++) {                                 \
+        if (old.used[i]) {                                                      \
+            Name##Put(map, old.keys[i], old.values[i]);                         \
+        }                                                                       \
+    }                                                                           \
+    free(old.keys);                                                             \
+    free(old.values);                                                           \
+    free(old.used);                                                             \
+}                                                                               \
+                                                                                \
+static inline void Name##Put(Name* map, K key, V value) {                       \
+    if (2 * (map->size + 1) > map->capacity) {                                  \
+        Name##Grow(map);                                                        \
+    }                                                                           \
+    size_t slot = Name##Slot(map, key);                                         \
+    if (!map->used[slot]) {                                                     \
+        map->used[slot] = 1;                                                    \
+        map->keys[slot] = key;                                                  \
+        map->size++;                                                            \
+    }                                                                           \
+    map->values[slot] = value;                                                  \
+}                                                                               \
+                                                                                \
+static inline V* Name##Get(Name* map, K key) {                                  \
+    if (map->capacity == 0) {                                                   \
+        return NULL;                                                            \
+    }                                                                           \
+    size_t slot = Name##Slot(map, key);                                         \
+    return map->used[slot] ? &map->values[slot] : NULL;                         \
+}                                                                               \
+                                                                                \
+static inline int Name##Remove(Name* map, K key) {                              \
+    if (map->capacity == 0) {                                                   \
+        return 0;                                                               \
+    }                                                                           \
+    size_t mask = map->capacity - 1;                                            \
+    size_t slot = Name##Slot(map, key);                                         \
+    if (!map->used[slot]) {                                                     \
+        return 0;                                                               \
+    }                                                                           \
+    map->used[slot] = 0;                                                        \
+    map->size--;                                                                \
+                                                                                \
+    /* move later entries of the probe run back into the hole so that */       \
+    /* lookups never stop early at it (no tombstones needed) */                 \
+    size_t hole = slot;                                                         \
+    size_t next = (slot + 1) & mask;                                            \
+    while (map->used[next]) {                                                   \
+        size_t home = hash(map->keys[next]) & mask;                             \
+        /* entry can move if its home isn't in (hole, next] */                  \
+        if (((next - home) & mask) >= ((next - hole) & mask)) {                 \
+            map->keys[hole] = map->keys[next];                                  \
+            map->values[hole] = map->values[next];                              \
+            map->used[hole] = 1;                                                \
+            map->used[next] = 0;                                                \
+            hole = next;                                                        \
+        }                                                                       \
+        next = (next + 1) & mask;                                               \
+    }                                                                           \
+    return 1;                                                                   \
+}                                                                               \
+                                                                                \
+static inline void Name##Free(Name* map) {                                      \
+    free(map->keys);                                                            \
+    free(map->values);                                                          \
+    free(map->used);                                                            \
+    Name##Init(map);                                                            \
+}
+
+#endif
@@ -1,17 +1,198 @@
 /** @file   linked_list.c
  *  @brief  An implementation of a linked list of integers in C.
+ *          The list is used through a handle that keeps the head, the
+ *          tail and the number of elements, so appending, pushing to the
+ *          front, getting the size and joining two lists are O(1). Lists
+ *          can be sorted and merged in place by relinking their nodes.
+ *          Nodes can come from a node pool (see node_pool.h) instead of
+ *          malloc(), see createListWithPool(), and a hash index can find
+ *          the node holding a value in O(1), see setListIndex().
+ *          Also contains an unrolled linked list that stores several
+ *          values per node to cut down on pointer chasing, a sorted
+ *          skip list with O(log n) search, insert and delete, and a
+ *          doubly linked list with O(1) operations on node handles.
+ *          The concurrent list is a lock-free sorted list that can be
+ *          shared between threads, with nodes freed through epochs.
+ *          Compile with -DBENCHMARK to run the benchmarks.
  *  @author Mustafa Siddiqui
  *  @date   01/13/2020
  */
 
+#define _POSIX_C_SOURCE 200809L     // clock_gettime()
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>                 // offsetof()
+#include <string.h>                 // memcpy(), memmove()
+#include <assert.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sched.h>                  // sched_yield()
+
+#ifdef BENCHMARK
+#include <time.h>                   // clock_gettime()
+#include <pthread.h>
+#endif
+
+#include "node_pool.h"
 
 struct linkedListNode {
     int value;
     struct linkedListNode* next;
 } typedef Node;
 
+/*
+    Entry of a list's hash index: how many nodes hold 'value' and the
+    first of them with the node before it (NULL for the head). 'node' is
+    NULL when it isn't known which node comes first after an insert or
+    delete of a duplicate value; the next lookup then scans for it.
+    Entries with 'count' 0 are empty.
+*/
+struct indexEntry {
+    int value;
+    int count;
+    Node* node;
+    Node* previous;
+} typedef indexEntry;
+
+/* Open-addressing (linear probing) hash map from value to entry. */
+struct listIndex {
+    indexEntry* entries;
+    size_t capacity;
+    size_t used;
+} typedef ListIndex;
+
+/* Starting capacity of an index, a power of 2 */
+#define INDEX_MIN_CAPACITY (16)
+
+/*
+    Struct to hold a linked list: first and last node, number of nodes,
+    the pool its nodes come from (NULL to use malloc()) and the hash
+    index (NULL when turned off).
+*/
+struct linkedList {
+    Node* head;
+    Node* tail;
+    long size;
+    NodePool* pool;
+    ListIndex* index;
+} typedef List;
+
+/* Bytes per node of an unrolled list, two cache lines */
+#define UNROLLED_NODE_BYTES (128)
+
+/* Values that fit in a node next to the link and count */
+#define UNROLLED_CAPACITY ((UNROLLED_NODE_BYTES - sizeof(void*) - sizeof(int)) / sizeof(int))
+
+/*
+    Node of an unrolled list: the values 'values[0..count)' in list
+    order. Nodes other than the last are kept at least half full,
+    so a walk takes one dependent load per UNROLLED_CAPACITY / 2 or more
+    values instead of one per value.
+*/
+struct unrolledNode {
+    struct unrolledNode* next;
+    int count;
+    int values[UNROLLED_CAPACITY];
+} typedef UnrolledNode;
+
+_Static_assert(sizeof(UnrolledNode) == UNROLLED_NODE_BYTES, "unrolled node must fill its cache lines");
+
+/* Struct to hold an unrolled list. */
+struct unrolledList {
+    UnrolledNode* head;
+    UnrolledNode* tail;
+    long size;
+} typedef UnrolledList;
+
+/* Most levels of a skip list, enough for 4^16 elements */
+#define SKIP_MAX_LEVEL (16)
+
+/*
+    Node of a skip list. A node is linked into levels 0 to height - 1;
+    level 0 links all nodes in sorted order like a plain linked list.
+*/
+struct skipNode {
+    int value;
+    int height;
+    struct skipNode* next[];
+} typedef SkipNode;
+
+/*
+    Struct to hold a skip list: values in ascending order, each node
+    getting a random height (one more level with probability 1/4) so
+    that a search skips over most nodes on the upper levels.
+    'finger' holds the last node before the last value searched on each
+    level. A search for a value at or after it starts there instead of
+    at the head, so it costs O(log d) for a value d nodes further on.
+*/
+struct skipList {
+    SkipNode* head;
+    int level;
+    long size;
+    SkipNode* finger[SKIP_MAX_LEVEL];
+    uint32_t random;
+} typedef SkipList;
+
+/*
+    Node of a doubly linked list. Functions that add a node return it as
+    a handle, so the caller can later remove or move it without a scan.
+    'link' holds the next node, except in XOR mode where it holds the
+    previous and next node XORed together and 'prev' is not allocated
+    (16 instead of 24 bytes per node).
+*/
+struct doublyNode {
+    int value;
+    uintptr_t link;
+    struct doublyNode* prev;
+} typedef DoublyNode;
+
+/*
+    Struct to hold a doubly linked list. In XOR mode a node's neighbors
+    can only be found from the other neighbor, so operations on a handle
+    in the middle of the list walk from the head to it; at the head and
+    the tail they stay O(1).
+*/
+struct doublyList {
+    DoublyNode* head;
+    DoublyNode* tail;
+    long size;
+    int useXorLinks;
+} typedef DoublyList;
+
+/* Size of a cache line, used to keep shared variables apart */
+#define CACHE_LINE_SIZE (64)
+
+/* Most threads that can use concurrent lists at the same time */
+#define MAX_EPOCH_THREADS (128)
+
+/* Removed nodes a thread collects before trying to advance the epoch */
+#define EPOCH_RETIRE_THRESHOLD (64)
+
+/* Low bit of a concurrent node's 'next' that marks the node deleted */
+#define DELETED_MARK ((uintptr_t) 1)
+
+/*
+    Node of a concurrent list. A node is deleted in two steps: first the
+    DELETED_MARK bit is set in its 'next' (after which 'next' never
+    changes), then the node is unlinked from its predecessor, by the
+    deleting thread or by any thread that passes it later. 'retired'
+    links the node into the removed nodes of the thread that unlinked it.
+*/
+struct concurrentNode {
+    int value;
+    _Atomic uintptr_t next;
+    struct concurrentNode* retired;
+} typedef ConcurrentNode;
+
+/*
+    Struct to hold a concurrent list: sorted values, each at most once.
+    'head' is a sentinel node before the first value.
+*/
+struct concurrentList {
+    ConcurrentNode head;
+} typedef ConcurrentList;
+
 /*
 __________________________________________________________________
 
@@ -20,65 +201,337 @@ __________________________________________________________________
 
 */
 
-/* 
+/*
+    Allocate memory for a list and initialize it to empty.
+*/
+List* createList(void);
+
+/*
+    Allocate memory for a list whose nodes are allocated from 'pool'.
+    Several lists can share a pool (nodes can only be moved between
+    lists on the same pool), but nothing other than lists may use it:
+    the last of them to be freed releases all of the pool's slabs at
+    once, the ones freed before give their nodes back one by one.
+*/
+List* createListWithPool(NodePool* pool);
+
+/*
     Append value to the end of the list.
 */
-Node* append(Node* head, int value);
+void append(List* list, int value);
+
+/*
+    Insert value at the start of the list.
+*/
+void pushFront(List* list, int value);
+
+/*
+    Number of elements in the list.
+*/
+long listSize(List* list);
+
+/*
+    Turn the hash index of the list on (1) or off (0). With the index,
+    finding the node of a value for insertAfter(), insertBefore(),
+    delete() and listContains() takes expected O(1) instead of a scan,
+    but every insert and delete also updates the index, and reversing
+    or concatenating rebuilds it. Worth it for lists that are mostly
+    searched, not for write-heavy ones.
+*/
+void setListIndex(List* list, int useIndex);
+
+/*
+    Returns 1 if value is in the list and 0 if not.
+*/
+int listContains(List* list, int value);
+
+/*
+    Move all elements of 'source' to the end of 'list', leaving 'source'
+    empty. Both lists must use the same pool (or none); 'source' stays
+    on it and can still be used or freed in any order. With an index
+    this takes time proportional to the size of 'source'.
+*/
+void concatenateLists(List* list, List* source);
 
 /*
     Insert value after some value/element in the list.
-    'valueBeforeInsert' is the value in the list after which the new 
+    'valueBeforeInsert' is the value in the list after which the new
     value will be inserted.
 */
-void insertAfter(Node* head, int valueBeforeInsert, int insertValue);
+void insertAfter(List* list, int valueBeforeInsert, int insertValue);
 
 /*
     Insert value before some value/element in the list.
     'valueAfterInsert' is the value in the list before which the new
     value will be inserted.
-    Returns Node* since the head of the list can be changed.
 */
-Node* insertBefore(Node* head, int valueAfterInsert, int insertValue);
+void insertBefore(List* list, int valueAfterInsert, int insertValue);
 
 /*
     Delete element from list.
 */
-void delete(Node* head, int valueToDelete);
+void delete(List* list, int valueToDelete);
 
 /*
     Search for value in the list.
-    Returns '-1' if value not found & the position/index of the value 
+    Returns '-1' if value not found & the position/index of the value
     in the list if found.
 */
-int search(Node* head, int valueToSearch);
+int search(List* list, int valueToSearch);
 
 /*
     Reverse list by editing the passed list instead of creating a new
-    one. Returns the head of the reversed list.
+    one.
 */
-Node* reverseList(Node* head);
+void reverseList(List* list);
 
 /*
     Reverse the list recursively.
-    Returns the updated head of the list.
 */
-Node* reverseListRecursively(Node* curr, Node* prev);
+void reverseListRecursively(List* list);
+
+/*
+    Sort the list in ascending order by relinking its nodes (stable,
+    O(n log n) time, O(1) extra space, no recursion). Runs that are
+    already in order (or in strictly descending order) are found and
+    used as they are, so nearly sorted lists take close to O(n).
+*/
+void sortList(List* list);
+
+/*
+    Merge the sorted list 'source' into the sorted list 'list' in O(n),
+    leaving 'source' empty. Equal values of 'list' come first. Both
+    lists must use the same pool (or none); 'source' stays on it, so it
+    can still be used, and freeing it only gives back its own nodes.
+*/
+void mergeSortedLists(List* list, List* source);
 
 /*
     Print all elements in the list.
 */
-void printList(Node* head);
+void printList(List* list);
 
 /*
     Print all elements in the list in reverse.
     Recursive function.
 */
-void printListReverse(Node* head);
+void printListReverse(List* list);
+
+/*
+    Free memory for all elements in the list and the list itself. If
+    it is the last list on its pool, this frees the pool's slabs instead
+    of one node at a time.
+*/
+void freeList(List* list);
+
+/*
+    Allocate memory for an unrolled list and initialize it to empty.
+*/
+UnrolledList* createUnrolledList(void);
+
+/*
+    Append value to the end of the unrolled list.
+*/
+void unrolledAppend(UnrolledList* list, int value);
+
+/*
+    Insert value after/before the first occurrence of some value in the
+    unrolled list, like insertAfter() and insertBefore(). A full node is
+    split in two.
+*/
+void unrolledInsertAfter(UnrolledList* list, int valueBeforeInsert, int insertValue);
+void unrolledInsertBefore(UnrolledList* list, int valueAfterInsert, int insertValue);
+
+/*
+    Delete the first occurrence of a value from the unrolled list. A node
+    that drops below half full takes values from the next node or is
+    merged with it.
+*/
+void unrolledDelete(UnrolledList* list, int valueToDelete);
+
+/*
+    Search for value in the unrolled list.
+    Returns '-1' if value not found & the position/index of the value
+    in the list if found.
+*/
+long unrolledSearch(UnrolledList* list, int valueToSearch);
+
+/*
+    Print all elements in the unrolled list.
+*/
+void printUnrolledList(UnrolledList* list);
+
+/*
+    Free memory for all nodes of the unrolled list and the list itself.
+*/
+void freeUnrolledList(UnrolledList* list);
+
+/*
+    Allocate memory for a skip list and initialize it to empty.
+*/
+SkipList* createSkipList(void);
+
+/*
+    Insert value into the skip list at its sorted position (after any
+    equal values).
+*/
+void skipInsert(SkipList* list, int value);
+
+/*
+    Delete one occurrence of value from the skip list.
+    Returns 1 if the value was deleted and 0 if it is not in the list.
+*/
+int skipDelete(SkipList* list, int valueToDelete);
+
+/*
+    Search for value in the skip list.
+    Returns 1 if value is in the list and 0 if not.
+*/
+int skipSearch(SkipList* list, int valueToSearch);
+
+/*
+    Print all elements of the skip list in order. Walks level 0 only, so
+    it is the same walk as printList().
+*/
+void printSkipList(SkipList* list);
+
+/*
+    Free memory for all nodes of the skip list and the list itself.
+*/
+void freeSkipList(SkipList* list);
+
+/*
+    Allocate memory for a doubly linked list and initialize it to empty.
+    Pass 1 as 'useXorLinks' for the compact XOR mode.
+*/
+DoublyList* createDoublyList(int useXorLinks);
+
+/*
+    Insert value at the start/end of the doubly linked list.
+    Returns the handle of the new node.
+*/
+DoublyNode* doublyPushFront(DoublyList* list, int value);
+DoublyNode* doublyAppend(DoublyList* list, int value);
+
+/*
+    Insert value right after/before the node 'node' of the list.
+    Returns the handle of the new node.
+*/
+DoublyNode* doublyInsertAfter(DoublyList* list, DoublyNode* node, int value);
+DoublyNode* doublyInsertBefore(DoublyList* list, DoublyNode* node, int value);
+
+/*
+    Delete the node 'node' from the list. The handle is invalid after.
+*/
+void doublyRemove(DoublyList* list, DoublyNode* node);
 
 /*
-    Free memory for all elements in the list.
+    Move the node 'node' to the start of the list (e.g. on a hit in an
+    LRU cache). The handle stays valid.
 */
-void freeList(Node* head);
+void doublyMoveToFront(DoublyList* list, DoublyNode* node);
+
+/*
+    Print all elements of the doubly linked list, from the start or in
+    reverse from the end.
+*/
+void printDoublyList(DoublyList* list);
+void printDoublyListReverse(DoublyList* list);
+
+/*
+    Free memory for all nodes of the doubly linked list and the list
+    itself.
+*/
+void freeDoublyList(DoublyList* list);
+
+/*
+    Allocate memory for a concurrent list and initialize it to empty.
+*/
+ConcurrentList* createConcurrentList(void);
+
+/*
+    Insert value into the concurrent list at its sorted position. Safe
+    to call from any number of threads.
+    Returns 1 if the value was inserted and 0 if it was already there.
+*/
+int concurrentInsert(ConcurrentList* list, int value);
+
+/*
+    Delete value from the concurrent list. Safe to call from any number
+    of threads.
+    Returns 1 if the value was deleted and 0 if it wasn't there.
+*/
+int concurrentDelete(ConcurrentList* list, int value);
+
+/*
+    Search value in the concurrent list. Wait-free: never retries and
+    never writes to the list, so it finishes in a bounded number of
+    steps whatever the other threads do.
+    Returns 1 if the value is there and 0 if not.
+*/
+int concurrentSearch(ConcurrentList* list, int value);
+
+/*
+    Print all elements of the concurrent list.
+*/
+void printConcurrentList(ConcurrentList* list);
+
+/*
+    Must be called by every thread that used a concurrent list before
+    it exits. Frees the nodes it removed (waiting for other threads to
+    leave the epoch they could have read them in if needed) and gives up
+    its epoch slot.
+*/
+void concurrentListThreadExit(void);
+
+/*
+    Free up allocated memory for the concurrent list and its nodes. No
+    thread may use the list after this is called.
+*/
+void freeConcurrentList(ConcurrentList* list);
+
+#ifdef BENCHMARK
+/*
+    Time to build a list by appending one element at a time.
+*/
+void benchmarkAppend(void);
+
+/*
+    Value-anchored operations and appends with and without the hash
+    index for growing list sizes, to find where the index pays off.
+*/
+void benchmarkIndex(void);
+
+/*
+    Full traversal of a linked and an unrolled list larger than the last
+    level cache, with nodes in allocation order and shuffled.
+*/
+void benchmarkTraversal(void);
+
+/*
+    Random and ascending lookups in a skip list compared with the linked
+    list.
+*/
+void benchmarkSkipList(void);
+
+/*
+    LRU cache hits (move to front) and evictions with the doubly linked
+    list in both modes compared with delete and pushFront on the list.
+*/
+void benchmarkLru(void);
+
+/*
+    sortList() on random, nearly sorted and descending lists compared
+    with copying the values to an array, qsort() and rebuilding.
+*/
+void benchmarkListSort(void);
+
+/*
+    Throughput of the concurrent list compared with a sorted list behind
+    a read-write lock, for 90% and 50% searches, on 1 to 32 threads.
+*/
+void benchmarkConcurrentList(void);
+#endif
 
 /*
 __________________________________________________________________
@@ -90,47 +543,161 @@ __________________________________________________________________
 
 int main(void) {
 
-    Node* head = (Node*) malloc(sizeof(Node));
-    head = NULL;
+    List* list = createList();
 
     // populate list and print
     for (int i = 0; i < 10; i++) {
-        head = append(head, (i + 1));
+        append(list, (i + 1));
     }
-    printList(head);
+    printList(list);
 
     // insert '99' into list after the value '5'
-    insertAfter(head, 5, 99);
-    printList(head);
+    insertAfter(list, 5, 99);
+    printList(list);
 
     // insert '101' into list before the value '99'
-    head = insertBefore(head, 1, 101);
-    printList(head);
+    insertBefore(list, 1, 101);
+    printList(list);
 
     // delete '99' from the list
-    delete(head, 99);
-    printList(head);
+    delete(list, 99);
+    printList(list);
 
     // print linked list in reverse without reversing it
     printf("List printed in reverse:\n");
-    printListReverse(head);
+    printListReverse(list);
     printf("\n");
 
     // reverse the list iteratively
     printf("Reversed list:\n");
-    head = reverseList(head);
-    printList(head);
+    reverseList(list);
+    printList(list);
 
     // reverse the list recursively
-    head = reverseListRecursively(head, NULL);
-    printList(head);
+    reverseListRecursively(list);
+    printList(list);
 
     // search '10' in list
     int valueToSearch = 1000;
-    printf("'%d' at position: %d\n", valueToSearch, search(head, valueToSearch));
+    printf("'%d' at position: %d\n", valueToSearch, search(list, valueToSearch));
+
+    // the same lookups through the hash index
+    setListIndex(list, 1);
+    insertAfter(list, 5, 99);
+    delete(list, 101);
+    printList(list);
+    printf("'%d' in list: %d\n", 99, listContains(list, 99));
+    delete(list, 99);
+    setListIndex(list, 0);
+
+    // join another list to the end
+    List* other = createList();
+    for (int i = 0; i < 5; i++) {
+        pushFront(other, (i + 11));
+    }
+    concatenateLists(list, other);
+    printList(list);
+    printf("Size of list: %ld\n", listSize(list));
+
+    // sort it, then merge in another sorted list
+    sortList(list);
+    printList(list);
+    for (int i = 0; i < 5; i++) {
+        append(other, (4 * i + 2));
+    }
+    mergeSortedLists(list, other);
+    printList(list);
 
     // free memory for all list nodes
-    freeList(head);
+    freeList(other);
+    freeList(list);
+
+    // same thing with nodes from a pool
+    NodePool* pool = createNodePool(sizeof(Node));
+    list = createListWithPool(pool);
+    for (int i = 0; i < 10; i++) {
+        append(list, (i + 1));
+    }
+    insertAfter(list, 5, 99);
+    insertBefore(list, 1, 101);
+    delete(list, 99);
+
+    // lists on the same pool can be joined, merged and freed in any order
+    other = createListWithPool(pool);
+    append(other, 11);
+    concatenateLists(list, other);
+    sortList(list);
+    append(other, 7);
+    append(other, 12);
+    mergeSortedLists(list, other);
+    freeList(other);
+    printList(list);
+    freeList(list);
+    freeNodePool(pool);
+
+    // same operations on an unrolled list
+    UnrolledList* unrolled = createUnrolledList();
+    for (int i = 0; i < 40; i++) {
+        unrolledAppend(unrolled, (i + 1));
+    }
+    unrolledInsertAfter(unrolled, 5, 99);
+    unrolledInsertBefore(unrolled, 1, 101);
+    unrolledDelete(unrolled, 99);
+    for (int i = 20; i <= 35; i++) {
+        unrolledDelete(unrolled, i);
+    }
+    printUnrolledList(unrolled);
+    printf("'%d' at position: %ld\n", 36, unrolledSearch(unrolled, 36));
+    freeUnrolledList(unrolled);
+
+    // skip list keeps values sorted whatever the insertion order
+    SkipList* skipList = createSkipList();
+    for (int i = 0; i < 10; i++) {
+        skipInsert(skipList, (i * 7) % 10 + 1);
+    }
+    skipDelete(skipList, 5);
+    printSkipList(skipList);
+    printf("'%d' found: %d, '%d' found: %d\n", 7, skipSearch(skipList, 7), 5, skipSearch(skipList, 5));
+    freeSkipList(skipList);
+
+    // doubly linked list, working on the handles returned by inserts
+    for (int useXorLinks = 0; useXorLinks <= 1; useXorLinks++) {
+        DoublyList* doubly = createDoublyList(useXorLinks);
+        DoublyNode* handles[10];
+        for (int i = 0; i < 10; i++) {
+            handles[i] = doublyAppend(doubly, (i + 1));
+        }
+        doublyInsertAfter(doubly, handles[4], 99);
+        doublyInsertBefore(doubly, handles[0], 101);
+        doublyRemove(doubly, handles[9]);
+        doublyMoveToFront(doubly, handles[6]);
+        printDoublyList(doubly);
+        printDoublyListReverse(doubly);
+        freeDoublyList(doubly);
+    }
+
+    // concurrent list (from a single thread here)
+    ConcurrentList* shared = createConcurrentList();
+    for (int i = 10; i > 0; i--) {
+        concurrentInsert(shared, i);
+    }
+    concurrentInsert(shared, 5);
+    concurrentDelete(shared, 3);
+    concurrentDelete(shared, 11);
+    printConcurrentList(shared);
+    printf("'%d' found: %d, '%d' found: %d\n", 7, concurrentSearch(shared, 7), 3, concurrentSearch(shared, 3));
+    freeConcurrentList(shared);
+    concurrentListThreadExit();
+
+    #ifdef BENCHMARK
+        benchmarkAppend();
+        benchmarkIndex();
+        benchmarkTraversal();
+        benchmarkSkipList();
+        benchmarkLru();
+        benchmarkListSort();
+        benchmarkConcurrentList();
+    #endif
 
     return 0;
 }
@@ -143,141 +710,432 @@ __________________________________________________________________
 
 */
 
-/* Append at end of list */
-Node* append(Node* head, int value) {
-    // create new node
-    Node* newNode = (Node*) malloc(sizeof(Node));
-    newNode->value = value;
-    newNode->next = NULL;
-
-    // if list empty, new node will become head
-    if (head == NULL) {
-        return newNode;
+/* New node from pool, or malloc() without one. */
+static Node* allocateNode(NodePool* pool) {
+    if (pool != NULL) {
+        return (Node*) poolAlloc(pool);
     }
+    return (Node*) malloc(sizeof(Node));
+}
 
-    // iterate to the end of the list
-    Node* currentNode = head;
-    while (currentNode->next != NULL) {
-        currentNode = currentNode->next;
+/* Free node back to pool, or free() without one. */
+static void releaseNode(Node* node, NodePool* pool) {
+    if (pool != NULL) {
+        poolFree(pool, node);
+    }
+    else {
+        free(node);
     }
-
-    // append new node
-    currentNode->next = newNode;
-
-    return head;
 }
 
-/* Insert value into list after some value. */
-void insertAfter(Node* head, int valueBeforeInsert, int insertValue) {
-    Node* currentNode = head;
-
-    // iterate over list until value reached
-    while (currentNode->value != valueBeforeInsert) {
-        currentNode = currentNode->next;
+/* Home slot of value in index. */
+static size_t indexHome(ListIndex* index, int value) {
+    return (size_t) (((uint64_t) (uint32_t) value * 0x9e3779b97f4a7c15ULL) >> 32) & (index->capacity - 1);
+}
 
-        // return if value not in list
-        if (currentNode == NULL) {
-            printf("'%d' not in list.\n", valueBeforeInsert);
-            return;
-        }
+/* Entry of value, or the empty slot where it would go. */
+static indexEntry* indexSlot(ListIndex* index, int value) {
+    size_t slot = indexHome(index, value);
+    while (index->entries[slot].count != 0 && index->entries[slot].value != value) {
+        slot = (slot + 1) & (index->capacity - 1);
     }
 
-    // create node to be inserted
-    Node* insertNode = (Node*) malloc(sizeof(Node));
-    insertNode->value = insertValue;
-    insertNode->next = currentNode->next;
+    return &index->entries[slot];
+}
 
-    // make current node point to node to be inserted (which points to the next node)
-    currentNode->next = insertNode;
+/* Entry of value, NULL if value not in index. */
+static indexEntry* indexLookup(ListIndex* index, int value) {
+    indexEntry* entry = indexSlot(index, value);
+    return (entry->count != 0) ? entry : NULL;
 }
 
-/* Insert value into list before some value. */
-Node* insertBefore(Node* head, int valueAfterInsert, int insertValue) {
-    Node* currentNode = head;
-    Node* previousNode = NULL;
-    
-    // iterate over loop until value reached
-    while (currentNode->value != valueAfterInsert) {
-        previousNode = currentNode;
-        currentNode = currentNode->next;
+/* Allocate empty index entries. */
+static void indexAllocate(ListIndex* index, size_t capacity) {
+    index->entries = (indexEntry*) calloc(capacity, sizeof(indexEntry));
+    assert(index->entries);
+    index->capacity = capacity;
+    index->used = 0;
+}
+
+/* Double index capacity, keeping it at most half full. */
+static void indexGrow(ListIndex* index) {
+    indexEntry* old = index->entries;
+    size_t oldCapacity = index->capacity;
 
-        // return if value not in list
-        if (currentNode == NULL) {
-            printf("'%d' not in list.\n", valueAfterInsert);
-            return head;
+    indexAllocate(index, 2 * oldCapacity);
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (old[i].count != 0) {
+            *indexSlot(index, old[i].value) = old[i];
+            index->used++;
         }
     }
+    free(old);
+}
 
-    // create node to be inserted
-    Node* insertNode = (Node*) malloc(sizeof(Node));
-    insertNode->value = insertValue;
-    insertNode->next = currentNode;
+/*
+    Add node (after 'previous') to index. 'order' tells where it is
+    relative to other nodes with the same value: -1 before all of them,
+    1 after all of them, 0 unknown.
+*/
+static void indexAddNode(ListIndex* index, Node* node, Node* previous, int order) {
+    if (2 * (index->used + 1) > index->capacity) {
+        indexGrow(index);
+    }
 
-    // if value is to be inserted before head
-    // currentNode will be the same as head in this case
-    if (head->value == valueAfterInsert) {
-        head = insertNode;
+    indexEntry* entry = indexSlot(index, node->value);
+    if (entry->count == 0) {
+        entry->value = node->value;
+        entry->node = node;
+        entry->previous = previous;
+        index->used++;
     }
-    else {
-        // make node before search value node point to node to be inserted (which points to the next node)
-        // previousNode will not be NULL since have iterated over list
-        previousNode->next = insertNode;
+    else if (order < 0) {
+        entry->node = node;
+        entry->previous = previous;
+    }
+    else if (order == 0) {
+        entry->node = NULL;
     }
+    entry->count++;
+}
 
-    return head;
+/* Node now comes after 'previous', update its entry if it is the first. */
+static void indexRelink(ListIndex* index, Node* node, Node* previous) {
+    if (node == NULL) {
+        return;
+    }
+
+    indexEntry* entry = indexLookup(index, node->value);
+    if (entry != NULL && entry->node == node) {
+        entry->previous = previous;
+    }
 }
 
-/* Delete value from list. */
-void delete(Node* head, int valueToDelete) {
-    Node* currentNode = head;
-    Node* previousNode = NULL;
+/* Remove node from index. */
+static void indexRemoveNode(ListIndex* index, Node* node) {
+    indexEntry* entry = indexSlot(index, node->value);
+    entry->count--;
+    if (entry->count > 0) {
+        // which node with this value comes first now is found on next lookup
+        entry->node = NULL;
+        return;
+    }
 
-    // iterate over list until value to be deleted is reached
-    while (currentNode->value != valueToDelete) {
-        previousNode = currentNode;
-        currentNode = currentNode->next;
+    // shift later entries of the probe run back into the gap (no tombstones)
+    size_t mask = index->capacity - 1;
+    size_t gap = (size_t) (entry - index->entries);
+    size_t slot = gap;
+    while (1) {
+        slot = (slot + 1) & mask;
+        if (index->entries[slot].count == 0) {
+            break;
+        }
 
-        // return if value not in list
-        if (currentNode == NULL) {
-            printf("'%d' not in list.\n", valueToDelete);
-            return;
+        size_t home = indexHome(index, index->entries[slot].value);
+        int between = (gap <= slot) ? (gap < home && home <= slot) : (gap < home || home <= slot);
+        if (!between) {
+            index->entries[gap] = index->entries[slot];
+            gap = slot;
         }
     }
+    index->entries[gap].count = 0;
+    index->used--;
+}
 
-    // connect previous and after nodes
-    previousNode->next = currentNode->next;
+/* Rebuild index from list nodes. */
+static void indexRebuild(List* list) {
+    ListIndex* index = list->index;
+    free(index->entries);
+    indexAllocate(index, INDEX_MIN_CAPACITY);
 
-    // free node with value to be deleted
-    free(currentNode);
+    Node* previousNode = NULL;
+    for (Node* node = list->head; node != NULL; node = node->next) {
+        indexAddNode(index, node, previousNode, 1);
+        previousNode = node;
+    }
+}
+
+/*
+    First node holding value and the node before it (NULL for the head).
+    Returns NULL if value not in list.
+*/
+static Node* findValue(List* list, int value, Node** previous) {
+    indexEntry* entry = NULL;
+    if (list->index != NULL) {
+        entry = indexLookup(list->index, value);
+        if (entry == NULL) {
+            return NULL;
+        }
+        if (entry->node != NULL) {
+            *previous = entry->previous;
+            return entry->node;
+        }
+    }
+
+    // iterate over list until value reached
+    Node* currentNode = list->head;
+    Node* previousNode = NULL;
+    while (currentNode != NULL && currentNode->value != value) {
+        previousNode = currentNode;
+        currentNode = currentNode->next;
+    }
+
+    // remember where it was for next time
+    if (entry != NULL) {
+        entry->node = currentNode;
+        entry->previous = previousNode;
+    }
+
+    *previous = previousNode;
+    return currentNode;
+}
+
+/* Create list and initialize. */
+List* createList(void) {
+    List* list = (List*) malloc(sizeof(List));
+    assert(list);
+
+    list->head = NULL;
+    list->tail = NULL;
+    list->size = 0;
+    list->pool = NULL;
+    list->index = NULL;
+
+    return list;
+}
+
+/* Create list with nodes from pool. */
+List* createListWithPool(NodePool* pool) {
+    List* list = createList();
+    list->pool = pool;
+    poolAttach(pool);
+
+    return list;
+}
+
+/* Append at end of list */
+void append(List* list, int value) {
+    // create new node
+    Node* newNode = allocateNode(list->pool);
+    newNode->value = value;
+    newNode->next = NULL;
+
+    // if list empty, new node will become head
+    if (list->head == NULL) {
+        list->head = newNode;
+    }
+    // otherwise it goes after the tail, no need to iterate to the end
+    else {
+        list->tail->next = newNode;
+    }
+
+    if (list->index != NULL) {
+        indexAddNode(list->index, newNode, list->tail, 1);
+    }
+    list->tail = newNode;
+    list->size++;
+}
+
+/* Insert at start of list. */
+void pushFront(List* list, int value) {
+    Node* newNode = allocateNode(list->pool);
+    newNode->value = value;
+    newNode->next = list->head;
+
+    if (list->head == NULL) {
+        list->tail = newNode;
+    }
+    if (list->index != NULL) {
+        indexAddNode(list->index, newNode, NULL, -1);
+        indexRelink(list->index, newNode->next, newNode);
+    }
+    list->head = newNode;
+    list->size++;
+}
+
+/* Turn hash index on or off. */
+void setListIndex(List* list, int useIndex) {
+    if (useIndex && list->index == NULL) {
+        list->index = (ListIndex*) malloc(sizeof(ListIndex));
+        assert(list->index);
+        list->index->entries = NULL;
+        indexRebuild(list);
+    }
+    else if (!useIndex && list->index != NULL) {
+        free(list->index->entries);
+        free(list->index);
+        list->index = NULL;
+    }
+}
+
+/* Check whether value is in list. */
+int listContains(List* list, int value) {
+    Node* previousNode;
+    return (findValue(list, value, &previousNode) != NULL);
+}
+
+/* Size of list. */
+long listSize(List* list) {
+    return list->size;
+}
+
+/* Move nodes of source list to end of list. */
+void concatenateLists(List* list, List* source) {
+    assert(list->pool == source->pool);
+    if (source->head == NULL) {
+        return;
+    }
+
+    // nodes of source come after all nodes already in list
+    if (list->index != NULL) {
+        Node* previousNode = list->tail;
+        for (Node* node = source->head; node != NULL; node = node->next) {
+            indexAddNode(list->index, node, previousNode, 1);
+            previousNode = node;
+        }
+    }
+
+    if (list->head == NULL) {
+        list->head = source->head;
+    }
+    else {
+        list->tail->next = source->head;
+    }
+    list->tail = source->tail;
+    list->size += source->size;
+
+    source->head = NULL;
+    source->tail = NULL;
+    source->size = 0;
+
+    if (source->index != NULL) {
+        indexRebuild(source);
+    }
+}
+
+/* Insert value into list after some value. */
+void insertAfter(List* list, int valueBeforeInsert, int insertValue) {
+    Node* previousNode;
+    Node* currentNode = findValue(list, valueBeforeInsert, &previousNode);
+
+    // return if value not in list
+    if (currentNode == NULL) {
+        printf("'%d' not in list.\n", valueBeforeInsert);
+        return;
+    }
+
+    // create node to be inserted
+    Node* insertNode = allocateNode(list->pool);
+    insertNode->value = insertValue;
+    insertNode->next = currentNode->next;
+
+    // make current node point to node to be inserted (which points to the next node)
+    currentNode->next = insertNode;
+
+    if (list->index != NULL) {
+        indexAddNode(list->index, insertNode, currentNode, (list->tail == currentNode) ? 1 : 0);
+        indexRelink(list->index, insertNode->next, insertNode);
+    }
+    if (list->tail == currentNode) {
+        list->tail = insertNode;
+    }
+    list->size++;
+}
+
+/* Insert value into list before some value. */
+void insertBefore(List* list, int valueAfterInsert, int insertValue) {
+    Node* previousNode;
+    Node* currentNode = findValue(list, valueAfterInsert, &previousNode);
+
+    // return if value not in list
+    if (currentNode == NULL) {
+        printf("'%d' not in list.\n", valueAfterInsert);
+        return;
+    }
+
+    // create node to be inserted
+    Node* insertNode = allocateNode(list->pool);
+    insertNode->value = insertValue;
+    insertNode->next = currentNode;
+
+    // if value is to be inserted before head
+    if (previousNode == NULL) {
+        list->head = insertNode;
+    }
+    else {
+        // make node before search value node point to node to be inserted (which points to the next node)
+        previousNode->next = insertNode;
+    }
+
+    if (list->index != NULL) {
+        indexAddNode(list->index, insertNode, previousNode, (previousNode == NULL) ? -1 : 0);
+        indexRelink(list->index, currentNode, insertNode);
+    }
+    list->size++;
+}
+
+/* Delete value from list. */
+void delete(List* list, int valueToDelete) {
+    Node* previousNode;
+    Node* currentNode = findValue(list, valueToDelete, &previousNode);
+
+    // return if value not in list
+    if (currentNode == NULL) {
+        printf("'%d' not in list.\n", valueToDelete);
+        return;
+    }
+
+    // connect previous and after nodes
+    if (previousNode == NULL) {
+        list->head = currentNode->next;
+    }
+    else {
+        previousNode->next = currentNode->next;
+    }
+    if (list->tail == currentNode) {
+        list->tail = previousNode;
+    }
+    if (list->index != NULL) {
+        indexRemoveNode(list->index, currentNode);
+        indexRelink(list->index, currentNode->next, previousNode);
+    }
+    list->size--;
+
+    // free node with value to be deleted
+    releaseNode(currentNode, list->pool);
 }
 
 /* Search value in list. */
-int search(Node* head, int valueToSearch) {
-    Node* currentNode = head;
+int search(List* list, int valueToSearch) {
+    // the index can only say whether it is there, the position takes a walk
+    if (list->index != NULL && indexLookup(list->index, valueToSearch) == NULL) {
+        return -1;
+    }
+
+    Node* currentNode = list->head;
 
     // iterate over list until value is found or till end of list while
     // keeping track of how many iterations made
     int index = 0;
-    while (currentNode->value != valueToSearch) {
+    while (currentNode != NULL) {
+        if (currentNode->value == valueToSearch) {
+            return index;
+        }
         currentNode = currentNode->next;
         index++;
-
-        if (currentNode == NULL) {
-            // value not found, return -1
-            return -1;
-        }
     }
 
-    return index;
+    // value not found
+    return -1;
 }
 
 /* Reverse list. */
-Node* reverseList(Node* head) {
-    if ((head == NULL) || head->next == NULL) {
-        return head;
+void reverseList(List* list) {
+    if ((list->head == NULL) || list->head->next == NULL) {
+        return;
     }
 
-    Node* currentNode = head;
+    Node* currentNode = list->head;
     Node* next = NULL;
     Node* prev = NULL;
     while (currentNode != NULL) {
@@ -288,19 +1146,22 @@ Node* reverseList(Node* head) {
         currentNode = next;
     }
 
-    head = prev;
+    list->tail = list->head;
+    list->head = prev;
 
-    return head;
+    if (list->index != NULL) {
+        indexRebuild(list);
+    }
 }
 
-/* Reverse list recursively. */
-Node* reverseListRecursively(Node* curr, Node* prev) {
+/* Reverse nodes recursively, returns new first node. */
+static Node* reverseNodesRecursively(Node* curr, Node* prev) {
     Node* head = curr;
-    
+
     // traverse recursively to end of list while
     // keeping track of current and previous nodes
     if (curr->next != NULL)
-        head = reverseListRecursively(curr->next, curr);
+        head = reverseNodesRecursively(curr->next, curr);
 
     // update head when end of list reached
     if (curr->next == NULL)
@@ -311,9 +1172,161 @@ Node* reverseListRecursively(Node* curr, Node* prev) {
     return head;
 }
 
+/* Reverse list recursively. */
+void reverseListRecursively(List* list) {
+    if (list->head == NULL) {
+        return;
+    }
+
+    list->tail = list->head;
+    list->head = reverseNodesRecursively(list->head, NULL);
+
+    if (list->index != NULL) {
+        indexRebuild(list);
+    }
+}
+
+/*
+    Cut the run of nodes starting at 'head' off the rest of the list: a
+    non-decreasing run, or a strictly descending one which is reversed.
+    Returns its first node and sets its last node and the rest.
+*/
+static Node* takeRun(Node* head, Node** runTail, Node** rest) {
+    Node* currentNode = head;
+
+    if (head->next != NULL && head->next->value < head->value) {
+        // reverse while descending; strictly, so equal values keep their order
+        Node* reversed = NULL;
+        Node* next;
+        do {
+            next = currentNode->next;
+            currentNode->next = reversed;
+            reversed = currentNode;
+            currentNode = next;
+        } while (currentNode != NULL && currentNode->value < reversed->value);
+
+        *runTail = head;
+        *rest = currentNode;
+        return reversed;
+    }
+
+    while (currentNode->next != NULL && currentNode->next->value >= currentNode->value) {
+        currentNode = currentNode->next;
+    }
+    *runTail = currentNode;
+    *rest = currentNode->next;
+    currentNode->next = NULL;
+
+    return head;
+}
+
+/*
+    Merge two sorted runs (NULL terminated) given with their last nodes.
+    Returns the first node of the result and sets its last node.
+*/
+static Node* mergeRuns(Node* a, Node* aTail, Node* b, Node* bTail, Node** tail) {
+    Node start;
+    Node* last = &start;
+
+    while (a != NULL && b != NULL) {
+        // take from 'a' on ties to keep the sort stable
+        if (a->value <= b->value) {
+            last->next = a;
+            a = a->next;
+        }
+        else {
+            last->next = b;
+            b = b->next;
+        }
+        last = last->next;
+    }
+
+    // the rest of one run is already in place
+    if (a != NULL) {
+        last->next = a;
+        *tail = aTail;
+    }
+    else {
+        last->next = b;
+        *tail = (b != NULL) ? bTail : last;
+    }
+
+    return start.next;
+}
+
+/* Number of bins of sortList(), enough for 2^64 runs */
+#define SORT_BINS (64)
+
+/* Sort list. */
+void sortList(List* list) {
+    // bin i holds a sorted run made of about 2^i of the input runs, the
+    // earlier part of the list in the higher bins. Merging each new run
+    // in like adding 1 to a binary counter merges runs of similar length
+    // while they were touched recently, instead of one pass over the
+    // whole list per level.
+    Node* bins[SORT_BINS] = {NULL};
+    Node* binTails[SORT_BINS];
+
+    Node* rest = list->head;
+    while (rest != NULL) {
+        Node* runTail;
+        Node* run = takeRun(rest, &runTail, &rest);
+
+        int i = 0;
+        while (i < SORT_BINS - 1 && bins[i] != NULL) {
+            run = mergeRuns(bins[i], binTails[i], run, runTail, &runTail);
+            bins[i] = NULL;
+            i++;
+        }
+        if (bins[i] != NULL) {
+            run = mergeRuns(bins[i], binTails[i], run, runTail, &runTail);
+        }
+        bins[i] = run;
+        binTails[i] = runTail;
+    }
+
+    // merge what is left in the bins, lowest (latest) first
+    Node* head = NULL;
+    Node* tail = NULL;
+    for (int i = 0; i < SORT_BINS; i++) {
+        if (bins[i] != NULL) {
+            head = mergeRuns(bins[i], binTails[i], head, tail, &tail);
+        }
+    }
+
+    list->head = head;
+    list->tail = tail;
+
+    if (list->index != NULL) {
+        indexRebuild(list);
+    }
+}
+
+/* Merge sorted list into sorted list. */
+void mergeSortedLists(List* list, List* source) {
+    assert(list->pool == source->pool);
+    if (source->head == NULL) {
+        return;
+    }
+
+    list->head = mergeRuns(list->head, list->tail, source->head, source->tail, &list->tail);
+    list->size += source->size;
+
+    source->head = NULL;
+    source->tail = NULL;
+    source->size = 0;
+
+    if (list->index != NULL) {
+        indexRebuild(list);
+    }
+    if (source->index != NULL) {
+        indexRebuild(source);
+    }
+}
+
 /* Print list. */
-void printList(Node* head) {
-    Node* currenNode = head;
+void printList(List* list) {
+    Node* currenNode = list->head;
 
     // iterate over list and print values
     while (currenNode != NULL) {
@@ -323,23 +1336,38 @@ void printList(Node* head) {
     printf("\n");
 }
 
-/* Print list in reverse. */
-void printListReverse(Node* head) {
+/* Print nodes in reverse. */
+static void printNodesReverse(Node* head) {
     // base case
     if (head == NULL) {
         return;
     }
-    
+
     // recursive call to next node
-    printListReverse(head->next);
+    printNodesReverse(head->next);
 
     // print data
     printf("%d ", head->value);
 }
 
+/* Print list in reverse. */
+void printListReverse(List* list) {
+    printNodesReverse(list->head);
+}
+
 /* Free up memory allocated for list. */
-void freeList(Node* head) {
-    Node* currentNode = head;
+void freeList(List* list) {
+    setListIndex(list, 0);
+
+    // the last list on a pool frees all nodes of the pool at once, the
+    // others may still hold some of them
+    if (list->pool != NULL && poolDetach(list->pool)) {
+        releaseNodePool(list->pool);
+        free(list);
+        return;
+    }
+
+    Node* currentNode = list->head;
     Node* previousNode = NULL;
 
     // iterate over the list and free nodes as we go
@@ -347,6 +1375,1567 @@ void freeList(Node* head) {
         previousNode = currentNode;
         currentNode = currentNode->next;
 
-        free(previousNode);
+        releaseNode(previousNode, list->pool);
+    }
+
+    free(list);
+}
+
+/* Allocate empty unrolled node. */
+static UnrolledNode* createUnrolledNode(void) {
+    UnrolledNode* node = (UnrolledNode*) aligned_alloc(64, sizeof(UnrolledNode));
+    assert(node);
+    node->next = NULL;
+    node->count = 0;
+
+    return node;
+}
+
+/* Create unrolled list and initialize. */
+UnrolledList* createUnrolledList(void) {
+    UnrolledList* list = (UnrolledList*) malloc(sizeof(UnrolledList));
+    assert(list);
+
+    list->head = NULL;
+    list->tail = NULL;
+    list->size = 0;
+
+    return list;
+}
+
+/* Append at end of unrolled list. */
+void unrolledAppend(UnrolledList* list, int value) {
+    // appended values fill the last node completely before a new one is started
+    if (list->tail == NULL || list->tail->count == (int) UNROLLED_CAPACITY) {
+        UnrolledNode* newNode = createUnrolledNode();
+        if (list->tail == NULL) {
+            list->head = newNode;
+        }
+        else {
+            list->tail->next = newNode;
+        }
+        list->tail = newNode;
+    }
+
+    list->tail->values[list->tail->count++] = value;
+    list->size++;
+}
+
+/* Find first node and position holding value, and the node before it. */
+static UnrolledNode* unrolledFind(UnrolledList* list, int value, int* position, UnrolledNode** previous) {
+    UnrolledNode* previousNode = NULL;
+    for (UnrolledNode* node = list->head; node != NULL; node = node->next) {
+        for (int i = 0; i < node->count; i++) {
+            if (node->values[i] == value) {
+                *position = i;
+                if (previous != NULL) {
+                    *previous = previousNode;
+                }
+                return node;
+            }
+        }
+        previousNode = node;
+    }
+
+    return NULL;
+}
+
+/* Insert value at position in node, splitting the node if full. */
+static void unrolledInsertAt(UnrolledList* list, UnrolledNode* node, int position, int value) {
+    if (node->count == (int) UNROLLED_CAPACITY) {
+        // move upper half of values to a new node after this one
+        UnrolledNode* newNode = createUnrolledNode();
+        int half = node->count / 2;
+        newNode->count = node->count - half;
+        memcpy(newNode->values, &node->values[half], newNode->count * sizeof(int));
+        node->count = half;
+
+        newNode->next = node->next;
+        node->next = newNode;
+        if (list->tail == node) {
+            list->tail = newNode;
+        }
+
+        if (position > half) {
+            node = newNode;
+            position -= half;
+        }
+    }
+
+    memmove(&node->values[position + 1], &node->values[position], (node->count - position) * sizeof(int));
+    node->values[position] = value;
+    node->count++;
+    list->size++;
+}
+
+/* Insert value into unrolled list after some value. */
+void unrolledInsertAfter(UnrolledList* list, int valueBeforeInsert, int insertValue) {
+    int position;
+    UnrolledNode* node = unrolledFind(list, valueBeforeInsert, &position, NULL);
+    if (node == NULL) {
+        printf("'%d' not in list.\n", valueBeforeInsert);
+        return;
+    }
+
+    unrolledInsertAt(list, node, position + 1, insertValue);
+}
+
+/* Insert value into unrolled list before some value. */
+void unrolledInsertBefore(UnrolledList* list, int valueAfterInsert, int insertValue) {
+    int position;
+    UnrolledNode* node = unrolledFind(list, valueAfterInsert, &position, NULL);
+    if (node == NULL) {
+        printf("'%d' not in list.\n", valueAfterInsert);
+        return;
+    }
+
+    unrolledInsertAt(list, node, position, insertValue);
+}
+
+/* Delete value from unrolled list. */
+void unrolledDelete(UnrolledList* list, int valueToDelete) {
+    int position;
+    UnrolledNode* previousNode;
+    UnrolledNode* node = unrolledFind(list, valueToDelete, &position, &previousNode);
+    if (node == NULL) {
+        printf("'%d' not in list.\n", valueToDelete);
+        return;
+    }
+
+    node->count--;
+    memmove(&node->values[position], &node->values[position + 1], (node->count - position) * sizeof(int));
+    list->size--;
+
+    // unlink node once empty
+    if (node->count == 0) {
+        if (previousNode == NULL) {
+            list->head = node->next;
+        }
+        else {
+            previousNode->next = node->next;
+        }
+        if (list->tail == node) {
+            list->tail = previousNode;
+        }
+        free(node);
+        return;
+    }
+
+    // refill node below half full from the next one, or merge both
+    UnrolledNode* next = node->next;
+    int half = UNROLLED_CAPACITY / 2;
+    if (node->count >= half || next == NULL) {
+        return;
     }
+
+    if (node->count + next->count <= (int) UNROLLED_CAPACITY) {
+        memcpy(&node->values[node->count], next->values, next->count * sizeof(int));
+        node->count += next->count;
+        node->next = next->next;
+        if (list->tail == next) {
+            list->tail = node;
+        }
+        free(next);
+    }
+    else {
+        int moved = half - node->count;
+        memcpy(&node->values[node->count], next->values, moved * sizeof(int));
+        node->count += moved;
+        next->count -= moved;
+        memmove(next->values, &next->values[moved], next->count * sizeof(int));
+    }
+}
+
+/* Search value in unrolled list. */
+long unrolledSearch(UnrolledList* list, int valueToSearch) {
+    long index = 0;
+    for (UnrolledNode* node = list->head; node != NULL; node = node->next) {
+        for (int i = 0; i < node->count; i++) {
+            if (node->values[i] == valueToSearch) {
+                return index + i;
+            }
+        }
+        index += node->count;
+    }
+
+    return -1;
+}
+
+/* Print unrolled list. */
+void printUnrolledList(UnrolledList* list) {
+    for (UnrolledNode* node = list->head; node != NULL; node = node->next) {
+        for (int i = 0; i < node->count; i++) {
+            printf("%d ", node->values[i]);
+        }
+    }
+    printf("\n");
 }
+
+/* Free up memory allocated for unrolled list. */
+void freeUnrolledList(UnrolledList* list) {
+    UnrolledNode* node = list->head;
+    while (node != NULL) {
+        UnrolledNode* next = node->next;
+        free(node);
+        node = next;
+    }
+
+    free(list);
+}
+
+/* Allocate skip list node linked into 'height' levels. */
+static SkipNode* createSkipNode(int value, int height) {
+    SkipNode* node = (SkipNode*) malloc(sizeof(SkipNode) + height * sizeof(SkipNode*));
+    assert(node);
+    node->value = value;
+    node->height = height;
+    for (int i = 0; i < height; i++) {
+        node->next[i] = NULL;
+    }
+
+    return node;
+}
+
+/* Create skip list and initialize. */
+SkipList* createSkipList(void) {
+    SkipList* list = (SkipList*) malloc(sizeof(SkipList));
+    assert(list);
+
+    // the head is a node without a value on every level
+    list->head = createSkipNode(0, SKIP_MAX_LEVEL);
+    list->level = 1;
+    list->size = 0;
+    for (int i = 0; i < SKIP_MAX_LEVEL; i++) {
+        list->finger[i] = list->head;
+    }
+    list->random = 0x9e3779b9;
+
+    return list;
+}
+
+/* Random node height, each level with probability 1/4 of the one below. */
+static int randomSkipHeight(SkipList* list) {
+    list->random ^= list->random << 13;
+    list->random ^= list->random >> 17;
+    list->random ^= list->random << 5;
+
+    uint32_t bits = list->random;
+    int height = 1;
+    while (height < SKIP_MAX_LEVEL && (bits & 3) == 0) {
+        height++;
+        bits >>= 2;
+    }
+
+    return height;
+}
+
+/*
+    Move the finger to the last node before 'value' on each level and
+    return the first node on level 0 with a value >= 'value' (or NULL).
+*/
+static SkipNode* skipFind(SkipList* list, int value) {
+    SkipNode** finger = list->finger;
+
+    // the finger is only of use for values after it, otherwise start over
+    if (finger[0] != list->head && finger[0]->value >= value) {
+        for (int i = 0; i < list->level; i++) {
+            finger[i] = list->head;
+        }
+    }
+
+    // climb until the finger on a level doesn't have to move: from there
+    // on up it already is the last node before 'value'
+    int top = 0;
+    while (top < list->level - 1 && finger[top]->next[top] != NULL &&
+           finger[top]->next[top]->value < value) {
+        top++;
+    }
+
+    // then search down from that level as usual
+    SkipNode* node = finger[top];
+    for (int i = top; i >= 0; i--) {
+        while (node->next[i] != NULL && node->next[i]->value < value) {
+            node = node->next[i];
+        }
+        finger[i] = node;
+    }
+
+    return node->next[0];
+}
+
+/* Insert value into skip list. */
+void skipInsert(SkipList* list, int value) {
+    // find last node before value + 1 so the new node goes after equal ones
+    SkipNode* next = skipFind(list, value);
+    while (next != NULL && next->value == value) {
+        for (int i = 0; i < next->height; i++) {
+            list->finger[i] = next;
+        }
+        next = next->next[0];
+    }
+
+    int height = randomSkipHeight(list);
+    if (height > list->level) {
+        for (int i = list->level; i < height; i++) {
+            list->finger[i] = list->head;
+        }
+        list->level = height;
+    }
+
+    // link new node after the finger on each of its levels
+    SkipNode* newNode = createSkipNode(value, height);
+    for (int i = 0; i < height; i++) {
+        newNode->next[i] = list->finger[i]->next[i];
+        list->finger[i]->next[i] = newNode;
+    }
+    list->size++;
+}
+
+/* Delete value from skip list. */
+int skipDelete(SkipList* list, int valueToDelete) {
+    SkipNode* node = skipFind(list, valueToDelete);
+    if (node == NULL || node->value != valueToDelete) {
+        return 0;
+    }
+
+    // the finger is the node before it on every level it is linked into
+    for (int i = 0; i < node->height; i++) {
+        list->finger[i]->next[i] = node->next[i];
+    }
+    free(node);
+    list->size--;
+
+    while (list->level > 1 && list->head->next[list->level - 1] == NULL) {
+        list->level--;
+    }
+
+    return 1;
+}
+
+/* Search value in skip list. */
+int skipSearch(SkipList* list, int valueToSearch) {
+    SkipNode* node = skipFind(list, valueToSearch);
+    return (node != NULL && node->value == valueToSearch);
+}
+
+/* Print skip list. */
+void printSkipList(SkipList* list) {
+    for (SkipNode* node = list->head->next[0]; node != NULL; node = node->next[0]) {
+        printf("%d ", node->value);
+    }
+    printf("\n");
+}
+
+/* Free up memory allocated for skip list. */
+void freeSkipList(SkipList* list) {
+    SkipNode* node = list->head;
+    while (node != NULL) {
+        SkipNode* next = node->next[0];
+        free(node);
+        node = next;
+    }
+
+    free(list);
+}
+
+/* Create doubly linked list and initialize. */
+DoublyList* createDoublyList(int useXorLinks) {
+    DoublyList* list = (DoublyList*) malloc(sizeof(DoublyList));
+    assert(list);
+
+    list->head = NULL;
+    list->tail = NULL;
+    list->size = 0;
+    list->useXorLinks = useXorLinks;
+
+    return list;
+}
+
+/* Next node after 'node' when coming from 'previous'. */
+static DoublyNode* doublyNext(DoublyList* list, DoublyNode* node, DoublyNode* previous) {
+    if (list->useXorLinks) {
+        return (DoublyNode*) (node->link ^ (uintptr_t) previous);
+    }
+    return (DoublyNode*) node->link;
+}
+
+/* Find the nodes before and after node (NULL at the ends). */
+static void doublyNeighbors(DoublyList* list, DoublyNode* node, DoublyNode** previous, DoublyNode** next) {
+    if (!list->useXorLinks) {
+        *previous = node->prev;
+        *next = (DoublyNode*) node->link;
+        return;
+    }
+
+    // at the ends one neighbor is NULL, so the link is the other one
+    if (node == list->head) {
+        *previous = NULL;
+    }
+    else if (node == list->tail) {
+        *previous = (DoublyNode*) node->link;
+    }
+    else {
+        DoublyNode* before = NULL;
+        DoublyNode* current = list->head;
+        while (current != node) {
+            DoublyNode* after = doublyNext(list, current, before);
+            before = current;
+            current = after;
+        }
+        *previous = before;
+    }
+    *next = (DoublyNode*) (node->link ^ (uintptr_t) *previous);
+}
+
+/* Link node in between the adjacent nodes previous and next. */
+static void doublyLink(DoublyList* list, DoublyNode* node, DoublyNode* previous, DoublyNode* next) {
+    if (list->useXorLinks) {
+        node->link = (uintptr_t) previous ^ (uintptr_t) next;
+        if (previous != NULL) {
+            previous->link ^= (uintptr_t) next ^ (uintptr_t) node;
+        }
+        if (next != NULL) {
+            next->link ^= (uintptr_t) previous ^ (uintptr_t) node;
+        }
+    }
+    else {
+        node->link = (uintptr_t) next;
+        node->prev = previous;
+        if (previous != NULL) {
+            previous->link = (uintptr_t) node;
+        }
+        if (next != NULL) {
+            next->prev = node;
+        }
+    }
+
+    if (previous == NULL) {
+        list->head = node;
+    }
+    if (next == NULL) {
+        list->tail = node;
+    }
+}
+
+/* Unlink node from between its neighbors previous and next. */
+static void doublyUnlink(DoublyList* list, DoublyNode* node, DoublyNode* previous, DoublyNode* next) {
+    if (list->useXorLinks) {
+        if (previous != NULL) {
+            previous->link ^= (uintptr_t) node ^ (uintptr_t) next;
+        }
+        if (next != NULL) {
+            next->link ^= (uintptr_t) node ^ (uintptr_t) previous;
+        }
+    }
+    else {
+        if (previous != NULL) {
+            previous->link = (uintptr_t) next;
+        }
+        if (next != NULL) {
+            next->prev = previous;
+        }
+    }
+
+    if (previous == NULL) {
+        list->head = next;
+    }
+    if (next == NULL) {
+        list->tail = previous;
+    }
+}
+
+/* Allocate node, without the 'prev' field in XOR mode. */
+static DoublyNode* createDoublyNode(DoublyList* list, int value) {
+    size_t size = list->useXorLinks ? offsetof(DoublyNode, prev) : sizeof(DoublyNode);
+    DoublyNode* node = (DoublyNode*) malloc(size);
+    assert(node);
+    node->value = value;
+    list->size++;
+
+    return node;
+}
+
+/* Insert at start of doubly linked list. */
+DoublyNode* doublyPushFront(DoublyList* list, int value) {
+    DoublyNode* node = createDoublyNode(list, value);
+    doublyLink(list, node, NULL, list->head);
+
+    return node;
+}
+
+/* Append at end of doubly linked list. */
+DoublyNode* doublyAppend(DoublyList* list, int value) {
+    DoublyNode* node = createDoublyNode(list, value);
+    doublyLink(list, node, list->tail, NULL);
+
+    return node;
+}
+
+/* Insert after node. */
+DoublyNode* doublyInsertAfter(DoublyList* list, DoublyNode* node, int value) {
+    DoublyNode* previous;
+    DoublyNode* next;
+    doublyNeighbors(list, node, &previous, &next);
+
+    DoublyNode* newNode = createDoublyNode(list, value);
+    doublyLink(list, newNode, node, next);
+
+    return newNode;
+}
+
+/* Insert before node. */
+DoublyNode* doublyInsertBefore(DoublyList* list, DoublyNode* node, int value) {
+    DoublyNode* previous;
+    DoublyNode* next;
+    doublyNeighbors(list, node, &previous, &next);
+
+    DoublyNode* newNode = createDoublyNode(list, value);
+    doublyLink(list, newNode, previous, node);
+
+    return newNode;
+}
+
+/* Delete node. */
+void doublyRemove(DoublyList* list, DoublyNode* node) {
+    DoublyNode* previous;
+    DoublyNode* next;
+    doublyNeighbors(list, node, &previous, &next);
+
+    doublyUnlink(list, node, previous, next);
+    list->size--;
+    free(node);
+}
+
+/* Move node to start of list. */
+void doublyMoveToFront(DoublyList* list, DoublyNode* node) {
+    if (node == list->head) {
+        return;
+    }
+
+    DoublyNode* previous;
+    DoublyNode* next;
+    doublyNeighbors(list, node, &previous, &next);
+
+    doublyUnlink(list, node, previous, next);
+    doublyLink(list, node, NULL, list->head);
+}
+
+/* Print doubly linked list. */
+void printDoublyList(DoublyList* list) {
+    DoublyNode* previous = NULL;
+    DoublyNode* node = list->head;
+    while (node != NULL) {
+        printf("%d ", node->value);
+        DoublyNode* next = doublyNext(list, node, previous);
+        previous = node;
+        node = next;
+    }
+    printf("\n");
+}
+
+/* Print doubly linked list from the end. */
+void printDoublyListReverse(DoublyList* list) {
+    DoublyNode* next = NULL;
+    DoublyNode* node = list->tail;
+    while (node != NULL) {
+        printf("%d ", node->value);
+        DoublyNode* previous = list->useXorLinks ? (DoublyNode*) (node->link ^ (uintptr_t) next) : node->prev;
+        next = node;
+        node = previous;
+    }
+    printf("\n");
+}
+
+/* Free up memory allocated for doubly linked list. */
+void freeDoublyList(DoublyList* list) {
+    DoublyNode* previous = NULL;
+    DoublyNode* node = list->head;
+    while (node != NULL) {
+        DoublyNode* next = doublyNext(list, node, previous);
+        previous = node;
+        free(node);
+        node = next;
+    }
+
+    free(list);
+}
+
+/*
+    Epoch-based reclamation: a thread publishes the global epoch in its
+    own slot for the duration of every operation on a concurrent list.
+    An unlinked node is tagged with the global epoch at that time and
+    freed once the global epoch is two further on: the epoch only moves
+    from e to e + 1 when every thread inside an operation is in e, so by
+    then no thread can still be in an operation that started before the
+    node was unlinked. Each thread claims a slot the first time it uses
+    a concurrent list.
+*/
+struct epochSlot {
+    _Alignas(CACHE_LINE_SIZE) atomic_ulong local;
+    atomic_int inUse;
+} typedef epochSlot;
+
+static _Alignas(CACHE_LINE_SIZE) atomic_ulong globalEpoch = 0;
+static epochSlot epochSlots[MAX_EPOCH_THREADS];
+
+/* Per thread: epoch slot and removed nodes by epoch (mod 3) */
+static _Thread_local epochSlot* threadEpochSlot = NULL;
+static _Thread_local ConcurrentNode* limboNodes[3];
+static _Thread_local unsigned long limboEpochs[3];
+static _Thread_local int retiredSinceAdvance = 0;
+
+/* Claim an epoch slot for this thread. */
+static epochSlot* getEpochSlot(void) {
+    if (threadEpochSlot == NULL) {
+        for (int i = 0; i < MAX_EPOCH_THREADS; i++) {
+            int expected = 0;
+            if (atomic_compare_exchange_strong(&epochSlots[i].inUse, &expected, 1)) {
+                threadEpochSlot = &epochSlots[i];
+                break;
+            }
+        }
+        assert(threadEpochSlot);
+    }
+    return threadEpochSlot;
+}
+
+/* Start an operation: publish the global epoch (low bit = active). */
+static void epochEnter(void) {
+    epochSlot* slot = getEpochSlot();
+    unsigned long epoch = atomic_load(&globalEpoch);
+    atomic_store(&slot->local, (epoch << 1) | 1);
+
+    // the epoch may have moved on before the store was visible; one more
+    // store is enough, as the first one already holds the epoch back
+    unsigned long current = atomic_load(&globalEpoch);
+    if (current != epoch) {
+        atomic_store(&slot->local, (current << 1) | 1);
+    }
+}
+
+/* End an operation. */
+static void epochExit(void) {
+    atomic_store_explicit(&threadEpochSlot->local, 0, memory_order_release);
+}
+
+/* Move the global epoch on if every active thread is in it. */
+static void tryAdvanceEpoch(void) {
+    unsigned long epoch = atomic_load(&globalEpoch);
+    for (int i = 0; i < MAX_EPOCH_THREADS; i++) {
+        unsigned long local = atomic_load(&epochSlots[i].local);
+        if ((local & 1) && (local >> 1) != epoch) {
+            return;
+        }
+    }
+    atomic_compare_exchange_strong(&globalEpoch, &epoch, epoch + 1);
+}
+
+/* Free a chain of removed nodes. */
+static void freeRetiredNodes(ConcurrentNode* node) {
+    while (node != NULL) {
+        ConcurrentNode* next = node->retired;
+        free(node);
+        node = next;
+    }
+}
+
+/* Free removed nodes of epochs at least two behind the global one. */
+static void freeLimboNodes(void) {
+    unsigned long epoch = atomic_load(&globalEpoch);
+    for (int i = 0; i < 3; i++) {
+        if (limboNodes[i] != NULL && limboEpochs[i] + 2 <= epoch) {
+            freeRetiredNodes(limboNodes[i]);
+            limboNodes[i] = NULL;
+        }
+    }
+}
+
+/* Free node once no thread can be reading it. */
+static void retireConcurrentNode(ConcurrentNode* node) {
+    unsigned long epoch = atomic_load(&globalEpoch);
+    int i = (int) (epoch % 3);
+
+    // nodes left in this slot are from epoch - 3 or earlier
+    if (limboEpochs[i] != epoch) {
+        freeRetiredNodes(limboNodes[i]);
+        limboNodes[i] = NULL;
+        limboEpochs[i] = epoch;
+    }
+    node->retired = limboNodes[i];
+    limboNodes[i] = node;
+
+    if (++retiredSinceAdvance == EPOCH_RETIRE_THRESHOLD) {
+        retiredSinceAdvance = 0;
+        tryAdvanceEpoch();
+        freeLimboNodes();
+    }
+}
+
+/* Node pointer of a concurrent node's 'next'. */
+static inline ConcurrentNode* unmarked(uintptr_t next) {
+    return (ConcurrentNode*) (next & ~DELETED_MARK);
+}
+
+/* Create concurrent list and initialize. */
+ConcurrentList* createConcurrentList(void) {
+    ConcurrentList* list = (ConcurrentList*) malloc(sizeof(ConcurrentList));
+    assert(list);
+    list->head.value = 0;
+    atomic_init(&list->head.next, (uintptr_t) NULL);
+    list->head.retired = NULL;
+
+    return list;
+}
+
+/*
+    First node with a value not less than 'value', and the link to it in
+    '*previous'. Unlinks the deleted nodes it passes, starting over from
+    the head if the node before one was changed in the meantime.
+*/
+static ConcurrentNode* concurrentFind(ConcurrentList* list, int value, _Atomic uintptr_t** previous) {
+    while (1) {
+        _Atomic uintptr_t* prev = &list->head.next;
+        ConcurrentNode* curr = unmarked(atomic_load_explicit(prev, memory_order_acquire));
+        int restart = 0;
+
+        while (curr != NULL) {
+            uintptr_t next = atomic_load_explicit(&curr->next, memory_order_acquire);
+            if (next & DELETED_MARK) {
+                // fails if the node before was deleted or linked elsewhere
+                uintptr_t expected = (uintptr_t) curr;
+                if (!atomic_compare_exchange_strong_explicit(prev, &expected, next & ~DELETED_MARK,
+                                                             memory_order_acq_rel, memory_order_relaxed)) {
+                    restart = 1;
+                    break;
+                }
+                retireConcurrentNode(curr);
+                curr = unmarked(next);
+                continue;
+            }
+            if (curr->value >= value) {
+                break;
+            }
+            prev = &curr->next;
+            curr = unmarked(next);
+        }
+
+        if (!restart) {
+            *previous = prev;
+            return curr;
+        }
+    }
+}
+
+/* Insert value into concurrent list. */
+int concurrentInsert(ConcurrentList* list, int value) {
+    ConcurrentNode* newNode = NULL;
+    _Atomic uintptr_t* prev;
+
+    epochEnter();
+    while (1) {
+        ConcurrentNode* curr = concurrentFind(list, value, &prev);
+        if (curr != NULL && curr->value == value) {
+            free(newNode);
+            epochExit();
+            return 0;
+        }
+
+        if (newNode == NULL) {
+            newNode = (ConcurrentNode*) malloc(sizeof(ConcurrentNode));
+            assert(newNode);
+            newNode->value = value;
+            newNode->retired = NULL;
+        }
+        atomic_store_explicit(&newNode->next, (uintptr_t) curr, memory_order_relaxed);
+
+        // fails if the node before was deleted or got a new next node
+        uintptr_t expected = (uintptr_t) curr;
+        if (atomic_compare_exchange_strong_explicit(prev, &expected, (uintptr_t) newNode,
+                                                    memory_order_release, memory_order_relaxed)) {
+            epochExit();
+            return 1;
+        }
+    }
+}
+
+/* Delete value from concurrent list. */
+int concurrentDelete(ConcurrentList* list, int value) {
+    _Atomic uintptr_t* prev;
+
+    epochEnter();
+    while (1) {
+        ConcurrentNode* curr = concurrentFind(list, value, &prev);
+        if (curr == NULL || curr->value != value) {
+            epochExit();
+            return 0;
+        }
+
+        // mark node deleted; retry if another thread deleted it first or
+        // inserted a node after it
+        uintptr_t next = atomic_load_explicit(&curr->next, memory_order_acquire);
+        if ((next & DELETED_MARK) ||
+            !atomic_compare_exchange_strong_explicit(&curr->next, &next, next | DELETED_MARK,
+                                                     memory_order_acq_rel, memory_order_relaxed)) {
+            continue;
+        }
+
+        // unlink it, or let a find do it if the node before changed
+        uintptr_t expected = (uintptr_t) curr;
+        if (atomic_compare_exchange_strong_explicit(prev, &expected, next,
+                                                    memory_order_acq_rel, memory_order_relaxed)) {
+            retireConcurrentNode(curr);
+        }
+        else {
+            concurrentFind(list, value, &prev);
+        }
+        epochExit();
+        return 1;
+    }
+}
+
+/* Search value in concurrent list. */
+int concurrentSearch(ConcurrentList* list, int value) {
+    epochEnter();
+
+    // walk past deleted nodes without unlinking them
+    ConcurrentNode* curr = unmarked(atomic_load_explicit(&list->head.next, memory_order_acquire));
+    while (curr != NULL && curr->value < value) {
+        curr = unmarked(atomic_load_explicit(&curr->next, memory_order_acquire));
+    }
+    int found = (curr != NULL && curr->value == value &&
+                 !(atomic_load_explicit(&curr->next, memory_order_acquire) & DELETED_MARK));
+
+    epochExit();
+    return found;
+}
+
+/* Print concurrent list. */
+void printConcurrentList(ConcurrentList* list) {
+    epochEnter();
+    ConcurrentNode* node = unmarked(atomic_load(&list->head.next));
+    while (node != NULL) {
+        uintptr_t next = atomic_load(&node->next);
+        if (!(next & DELETED_MARK)) {
+            printf("%d ", node->value);
+        }
+        node = unmarked(next);
+    }
+    printf("\n");
+    epochExit();
+}
+
+/* Clean up calling thread. */
+void concurrentListThreadExit(void) {
+    if (threadEpochSlot == NULL) {
+        return;
+    }
+
+    // other threads still in an old epoch are only there briefly
+    atomic_store(&threadEpochSlot->local, 0);
+    while (limboNodes[0] != NULL || limboNodes[1] != NULL || limboNodes[2] != NULL) {
+        tryAdvanceEpoch();
+        freeLimboNodes();
+        if (limboNodes[0] != NULL || limboNodes[1] != NULL || limboNodes[2] != NULL) {
+            sched_yield();
+        }
+    }
+    retiredSinceAdvance = 0;
+
+    atomic_store(&threadEpochSlot->inUse, 0);
+    threadEpochSlot = NULL;
+}
+
+/* Free up memory allocated for concurrent list. */
+void freeConcurrentList(ConcurrentList* list) {
+    // nodes that are marked but still linked haven't been retired
+    ConcurrentNode* node = unmarked(atomic_load(&list->head.next));
+    while (node != NULL) {
+        ConcurrentNode* next = unmarked(atomic_load(&node->next));
+        free(node);
+        node = next;
+    }
+
+    free(list);
+}
+
+/*
+__________________________________________________________________
+
+                            BENCHMARKS
+__________________________________________________________________
+
+*/
+
+#ifdef BENCHMARK
+
+/* Elements appended to the list */
+#ifndef BENCHMARK_ELEMENTS
+#define BENCHMARK_ELEMENTS (1000000L)
+#endif
+
+/* Seconds between two timestamps. */
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/* Pseudo-random index below n, the same for every run. */
+static long randomIndex(unsigned long long* state, long n) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (long) ((*state >> 33) % (unsigned long long) n);
+}
+
+/* Run append benchmark. */
+void benchmarkAppend(void) {
+    struct timespec start, end;
+
+    printf("\nAppend %ld elements\n", BENCHMARK_ELEMENTS);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    List* list = createList();
+    for (long i = 0; i < BENCHMARK_ELEMENTS; i++) {
+        append(list, (int) i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  malloc  %6.2f ns/element (size %ld)\n",
+           elapsedSeconds(start, end) / BENCHMARK_ELEMENTS * 1e9, listSize(list));
+    freeList(list);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    NodePool* pool = createNodePool(sizeof(Node));
+    list = createListWithPool(pool);
+    for (long i = 0; i < BENCHMARK_ELEMENTS; i++) {
+        append(list, (int) i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  pooled  %6.2f ns/element (size %ld)\n",
+           elapsedSeconds(start, end) / BENCHMARK_ELEMENTS * 1e9, listSize(list));
+    freeList(list);
+    freeNodePool(pool);
+}
+
+/* Operations timed per list size and workload */
+#ifndef BENCHMARK_INDEX_OPERATIONS
+#define BENCHMARK_INDEX_OPERATIONS (20000L)
+#endif
+
+/* Largest list size in the index benchmark */
+#ifndef BENCHMARK_INDEX_MAX_SIZE
+#define BENCHMARK_INDEX_MAX_SIZE (16384L)
+#endif
+
+/*
+    ns per operation for a list of 'size' distinct values, with or
+    without index. 'anchored' inserts after a random value and deletes
+    the inserted value again, otherwise it appends a value and deletes
+    the first one (no scan needed either way).
+*/
+static double timeIndexWorkload(long size, int useIndex, int anchored) {
+    struct timespec start, end;
+    unsigned long long state = 1;
+
+    List* list = createList();
+    for (long i = 0; i < size; i++) {
+        append(list, (int) i);
+    }
+    setListIndex(list, useIndex);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < BENCHMARK_INDEX_OPERATIONS; i++) {
+        int value = (int) (size + i);
+        if (anchored) {
+            insertAfter(list, (int) randomIndex(&state, size), value);
+            delete(list, value);
+        }
+        else {
+            append(list, value);
+            delete(list, list->head->value);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    freeList(list);
+
+    return elapsedSeconds(start, end) / (2.0 * BENCHMARK_INDEX_OPERATIONS) * 1e9;
+}
+
+/* Run index benchmark. */
+void benchmarkIndex(void) {
+    printf("\nHash index, ns per operation (without / with index)\n");
+    printf("  %8s %22s %22s\n", "size", "insertAfter+delete", "append+delete head");
+
+    for (long size = 4; size <= BENCHMARK_INDEX_MAX_SIZE; size *= 2) {
+        printf("  %8ld %10.1f / %9.1f %10.1f / %9.1f\n", size,
+               timeIndexWorkload(size, 0, 1), timeIndexWorkload(size, 1, 1),
+               timeIndexWorkload(size, 0, 0), timeIndexWorkload(size, 1, 0));
+    }
+}
+
+/* Elements per traversed list, far more than fits in the last level
+   cache as linked nodes (32 bytes per value with malloc overhead) */
+#ifndef BENCHMARK_TRAVERSAL_ELEMENTS
+#define BENCHMARK_TRAVERSAL_ELEMENTS (1L << 24)
+#endif
+
+/* Full traversals timed per layout */
+#ifndef BENCHMARK_TRAVERSALS
+#define BENCHMARK_TRAVERSALS (5)
+#endif
+
+/* Relink nodes of the list in random order, so that each next node is
+   somewhere else in memory as in a list built up over time. */
+static void shuffleListNodes(List* list) {
+    Node** nodes = (Node**) malloc(list->size * sizeof(Node*));
+    assert(nodes);
+    long n = 0;
+    for (Node* node = list->head; node != NULL; node = node->next) {
+        nodes[n++] = node;
+    }
+
+    unsigned long long state = 1;
+    for (long i = n - 1; i > 0; i--) {
+        long j = randomIndex(&state, i + 1);
+        Node* temp = nodes[i];
+        nodes[i] = nodes[j];
+        nodes[j] = temp;
+    }
+    for (long i = 0; i < n - 1; i++) {
+        nodes[i]->next = nodes[i + 1];
+    }
+    nodes[n - 1]->next = NULL;
+    list->head = nodes[0];
+    list->tail = nodes[n - 1];
+
+    free(nodes);
+}
+
+static void shuffleUnrolledNodes(UnrolledList* list) {
+    long n = 0;
+    for (UnrolledNode* node = list->head; node != NULL; node = node->next) {
+        n++;
+    }
+    UnrolledNode** nodes = (UnrolledNode**) malloc(n * sizeof(UnrolledNode*));
+    assert(nodes);
+    n = 0;
+    for (UnrolledNode* node = list->head; node != NULL; node = node->next) {
+        nodes[n++] = node;
+    }
+
+    unsigned long long state = 1;
+    for (long i = n - 1; i > 0; i--) {
+        long j = randomIndex(&state, i + 1);
+        UnrolledNode* temp = nodes[i];
+        nodes[i] = nodes[j];
+        nodes[j] = temp;
+    }
+    for (long i = 0; i < n - 1; i++) {
+        nodes[i]->next = nodes[i + 1];
+    }
+    nodes[n - 1]->next = NULL;
+    list->head = nodes[0];
+    list->tail = nodes[n - 1];
+
+    free(nodes);
+}
+
+/* Time searches for a missing value, i.e. full walks, in ns per element. */
+static double timeListWalks(List* list) {
+    struct timespec start, end;
+    long found = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCHMARK_TRAVERSALS; i++) {
+        found += search(list, -1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    assert(found == -BENCHMARK_TRAVERSALS);
+
+    return elapsedSeconds(start, end) / BENCHMARK_TRAVERSALS / list->size * 1e9;
+}
+
+static double timeUnrolledWalks(UnrolledList* list) {
+    struct timespec start, end;
+    long found = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCHMARK_TRAVERSALS; i++) {
+        found += unrolledSearch(list, -1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    assert(found == -BENCHMARK_TRAVERSALS);
+
+    return elapsedSeconds(start, end) / BENCHMARK_TRAVERSALS / list->size * 1e9;
+}
+
+/* Run traversal benchmark. */
+void benchmarkTraversal(void) {
+    long n = BENCHMARK_TRAVERSAL_ELEMENTS;
+    printf("\nFull traversal of %ld elements, ns per element (sequential / shuffled nodes)\n", n);
+
+    List* list = createList();
+    for (long i = 0; i < n; i++) {
+        append(list, (int) i);
+    }
+    double sequential = timeListWalks(list);
+    shuffleListNodes(list);
+    printf("  linked         %6.2f / %6.2f\n", sequential, timeListWalks(list));
+    freeList(list);
+
+    // appended, so all nodes are full
+    UnrolledList* unrolled = createUnrolledList();
+    for (long i = 0; i < n; i++) {
+        unrolledAppend(unrolled, (int) i);
+    }
+    sequential = timeUnrolledWalks(unrolled);
+    shuffleUnrolledNodes(unrolled);
+    printf("  unrolled full  %6.2f / %6.2f\n", sequential, timeUnrolledWalks(unrolled));
+    freeUnrolledList(unrolled);
+
+    // split every node by inserting in the middle of it: nodes half full
+    unrolled = createUnrolledList();
+    for (long i = 0; i < n; i++) {
+        unrolledAppend(unrolled, (int) i);
+    }
+    for (UnrolledNode* node = unrolled->head; node != NULL; ) {
+        UnrolledNode* next = node->next;
+        unrolledInsertAt(unrolled, node, node->count / 2, 0);
+        node = next;
+    }
+    sequential = timeUnrolledWalks(unrolled);
+    shuffleUnrolledNodes(unrolled);
+    printf("  unrolled half  %6.2f / %6.2f\n", sequential, timeUnrolledWalks(unrolled));
+    freeUnrolledList(unrolled);
+}
+
+/* Elements in the lists searched */
+#ifndef BENCHMARK_SKIP_ELEMENTS
+#define BENCHMARK_SKIP_ELEMENTS (1000000L)
+#endif
+
+/* Lookups in the skip list, and in the linked list (each is a scan) */
+#ifndef BENCHMARK_SKIP_LOOKUPS
+#define BENCHMARK_SKIP_LOOKUPS (1000000L)
+#endif
+
+#ifndef BENCHMARK_LINKED_LOOKUPS
+#define BENCHMARK_LINKED_LOOKUPS (200L)
+#endif
+
+/* Run skip list benchmark. */
+void benchmarkSkipList(void) {
+    struct timespec start, end;
+    long n = BENCHMARK_SKIP_ELEMENTS;
+    unsigned long long state = 1;
+    long found = 0;
+
+    // even values only, so that about half of all lookups miss
+    printf("\nLookups among %ld sorted elements, ns per lookup\n", n);
+
+    List* list = createList();
+    for (long i = 0; i < n; i++) {
+        append(list, (int) (2 * i));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < BENCHMARK_LINKED_LOOKUPS; i++) {
+        found += (search(list, (int) randomIndex(&state, 2 * n)) >= 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  linked  random    %10.1f\n", elapsedSeconds(start, end) / BENCHMARK_LINKED_LOOKUPS * 1e9);
+    freeList(list);
+
+    // insert in random order so nodes are scattered over memory
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    SkipList* skipList = createSkipList();
+    for (long i = 0; i < n; i++) {
+        skipInsert(skipList, (int) (2 * ((i * 7919) % n)));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  skip    insert    %10.1f\n", elapsedSeconds(start, end) / n * 1e9);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < BENCHMARK_SKIP_LOOKUPS; i++) {
+        found += skipSearch(skipList, (int) randomIndex(&state, 2 * n));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  skip    random    %10.1f\n", elapsedSeconds(start, end) / BENCHMARK_SKIP_LOOKUPS * 1e9);
+
+    // ascending lookups a few elements apart, where the finger helps
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < BENCHMARK_SKIP_LOOKUPS; i++) {
+        found += skipSearch(skipList, (int) ((i * 8) % (2 * n)));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  skip    ascending %10.1f (found %ld)\n",
+           elapsedSeconds(start, end) / BENCHMARK_SKIP_LOOKUPS * 1e9, found);
+
+    freeSkipList(skipList);
+}
+
+/* Entries held by the LRU cache, and keys requested from it */
+#ifndef BENCHMARK_LRU_CAPACITY
+#define BENCHMARK_LRU_CAPACITY (10000L)
+#endif
+
+#ifndef BENCHMARK_LRU_KEYS
+#define BENCHMARK_LRU_KEYS (12000L)
+#endif
+
+#ifndef BENCHMARK_LRU_REQUESTS
+#define BENCHMARK_LRU_REQUESTS (200000L)
+#endif
+
+/* ns per request of an LRU cache on a doubly linked list; the handle of
+   each cached key is kept in an array indexed by key. */
+static double timeDoublyLru(int useXorLinks, long* hits) {
+    struct timespec start, end;
+    unsigned long long state = 1;
+    DoublyNode** handles = (DoublyNode**) calloc(BENCHMARK_LRU_KEYS, sizeof(DoublyNode*));
+    assert(handles);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    DoublyList* cache = createDoublyList(useXorLinks);
+    for (long i = 0; i < BENCHMARK_LRU_REQUESTS; i++) {
+        int key = (int) randomIndex(&state, BENCHMARK_LRU_KEYS);
+        if (handles[key] != NULL) {
+            doublyMoveToFront(cache, handles[key]);
+            (*hits)++;
+            continue;
+        }
+
+        // miss: evict least recently used entry at the end if full
+        if (cache->size == BENCHMARK_LRU_CAPACITY) {
+            handles[cache->tail->value] = NULL;
+            doublyRemove(cache, cache->tail);
+        }
+        handles[key] = doublyPushFront(cache, key);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    freeDoublyList(cache);
+    free(handles);
+
+    return elapsedSeconds(start, end) / BENCHMARK_LRU_REQUESTS * 1e9;
+}
+
+/* Same cache on the singly linked list: a hit deletes the key (a scan)
+   and pushes it to the front again. */
+static double timeListLru(long* hits) {
+    struct timespec start, end;
+    unsigned long long state = 1;
+    char* cached = (char*) calloc(BENCHMARK_LRU_KEYS, 1);
+    assert(cached);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    List* cache = createList();
+    for (long i = 0; i < BENCHMARK_LRU_REQUESTS; i++) {
+        int key = (int) randomIndex(&state, BENCHMARK_LRU_KEYS);
+        if (cached[key]) {
+            delete(cache, key);
+            pushFront(cache, key);
+            (*hits)++;
+            continue;
+        }
+
+        if (cache->size == BENCHMARK_LRU_CAPACITY) {
+            int evicted = cache->tail->value;
+            cached[evicted] = 0;
+            delete(cache, evicted);
+        }
+        pushFront(cache, key);
+        cached[key] = 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    freeList(cache);
+    free(cached);
+
+    return elapsedSeconds(start, end) / BENCHMARK_LRU_REQUESTS * 1e9;
+}
+
+/* Run LRU benchmark. */
+void benchmarkLru(void) {
+    long hits[3] = {0, 0, 0};
+
+    printf("\nLRU cache of %ld entries, %ld keys, ns per request\n",
+           BENCHMARK_LRU_CAPACITY, BENCHMARK_LRU_KEYS);
+    printf("  doubly    %10.1f (%zu bytes per node)\n", timeDoublyLru(0, &hits[0]), sizeof(DoublyNode));
+    printf("  xor       %10.1f (%zu bytes per node)\n", timeDoublyLru(1, &hits[1]), offsetof(DoublyNode, prev));
+    double singly = timeListLru(&hits[2]);
+    printf("  singly    %10.1f (hits %ld %ld %ld)\n", singly, hits[0], hits[1], hits[2]);
+}
+
+/* Elements per sorted list */
+#ifndef BENCHMARK_SORT_ELEMENTS
+#define BENCHMARK_SORT_ELEMENTS (10000000L)
+#endif
+
+/* Order of the values in the list before sorting */
+enum sortInput {
+    SORT_RANDOM,
+    SORT_NEARLY_SORTED,
+    SORT_DESCENDING
+} typedef sortInput;
+
+/* Fill list with n values in the given order. */
+static List* createSortInput(long n, sortInput input) {
+    unsigned long long state = 1;
+    List* list = createList();
+
+    for (long i = 0; i < n; i++) {
+        int value;
+        if (input == SORT_RANDOM) {
+            value = (int) randomIndex(&state, n);
+        }
+        else if (input == SORT_NEARLY_SORTED) {
+            // one in a hundred values out of place
+            value = (randomIndex(&state, 100) == 0) ? (int) randomIndex(&state, n) : (int) i;
+        }
+        else {
+            value = (int) (n - i);
+        }
+        append(list, value);
+    }
+
+    return list;
+}
+
+static int compareInts(const void* a, const void* b) {
+    int x = *(const int*) a;
+    int y = *(const int*) b;
+    return (x > y) - (x < y);
+}
+
+/* Sort by copying values out, qsort() and building a new list. */
+static void sortListByCopy(List* list) {
+    int* values = (int*) malloc(list->size * sizeof(int));
+    assert(values);
+    long n = 0;
+    for (Node* node = list->head; node != NULL; node = node->next) {
+        values[n++] = node->value;
+    }
+    qsort(values, n, sizeof(int), compareInts);
+
+    List* sorted = createList();
+    for (long i = 0; i < n; i++) {
+        append(sorted, values[i]);
+    }
+    free(values);
+
+    // swap the new nodes into the handle and free the old ones
+    List old = *list;
+    *list = *sorted;
+    *sorted = old;
+    freeList(sorted);
+}
+
+/* Check list is sorted. */
+static int isSorted(List* list) {
+    for (Node* node = list->head; node != NULL && node->next != NULL; node = node->next) {
+        if (node->next->value < node->value) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Run list sort benchmark. */
+void benchmarkListSort(void) {
+    struct timespec start, end;
+    const char* names[] = {"random", "nearly sorted", "descending"};
+
+    printf("\nSort %ld elements, seconds (sortList / array copy + qsort)\n", BENCHMARK_SORT_ELEMENTS);
+    for (int input = SORT_RANDOM; input <= SORT_DESCENDING; input++) {
+        List* list = createSortInput(BENCHMARK_SORT_ELEMENTS, (sortInput) input);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        sortList(list);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double inPlace = elapsedSeconds(start, end);
+        assert(isSorted(list));
+        freeList(list);
+
+        list = createSortInput(BENCHMARK_SORT_ELEMENTS, (sortInput) input);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        sortListByCopy(list);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        assert(isSorted(list));
+        freeList(list);
+
+        printf("  %-14s %7.3f / %7.3f\n", names[input], inPlace, elapsedSeconds(start, end));
+    }
+}
+
+/* Operations per run, shared between the threads */
+#ifndef BENCHMARK_CONCURRENT_OPERATIONS
+#define BENCHMARK_CONCURRENT_OPERATIONS (2000000L)
+#endif
+
+/* Values are drawn from [0, BENCHMARK_CONCURRENT_KEYS), half are in the list */
+#ifndef BENCHMARK_CONCURRENT_KEYS
+#define BENCHMARK_CONCURRENT_KEYS (1024L)
+#endif
+
+#define MAX_BENCHMARK_THREADS (32)
+
+/* Sorted list behind a read-write lock, what sharing it takes without
+   the concurrent list. */
+static pthread_rwlock_t lockedListLock = PTHREAD_RWLOCK_INITIALIZER;
+static Node* lockedListHead = NULL;
+
+static int lockedListInsert(int value) {
+    pthread_rwlock_wrlock(&lockedListLock);
+    Node** link = &lockedListHead;
+    while (*link != NULL && (*link)->value < value) {
+        link = &(*link)->next;
+    }
+    int inserted = (*link == NULL || (*link)->value != value);
+    if (inserted) {
+        Node* newNode = (Node*) malloc(sizeof(Node));
+        assert(newNode);
+        newNode->value = value;
+        newNode->next = *link;
+        *link = newNode;
+    }
+    pthread_rwlock_unlock(&lockedListLock);
+    return inserted;
+}
+
+static int lockedListDelete(int value) {
+    pthread_rwlock_wrlock(&lockedListLock);
+    Node** link = &lockedListHead;
+    while (*link != NULL && (*link)->value < value) {
+        link = &(*link)->next;
+    }
+    int deleted = (*link != NULL && (*link)->value == value);
+    if (deleted) {
+        Node* node = *link;
+        *link = node->next;
+        free(node);
+    }
+    pthread_rwlock_unlock(&lockedListLock);
+    return deleted;
+}
+
+static int lockedListSearch(int value) {
+    pthread_rwlock_rdlock(&lockedListLock);
+    Node* node = lockedListHead;
+    while (node != NULL && node->value < value) {
+        node = node->next;
+    }
+    int found = (node != NULL && node->value == value);
+    pthread_rwlock_unlock(&lockedListLock);
+    return found;
+}
+
+/* Arguments and results of a benchmark thread. */
+struct listBenchmarkArgs {
+    ConcurrentList* list;
+    int searchPercent;
+    long operations;
+    unsigned long long seed;
+    long hits;
+} typedef listBenchmarkArgs;
+
+/* Each thread searches 'searchPercent' of the time and otherwise
+   inserts or deletes (equally often) a random value. */
+static void* concurrentListWorker(void* arg) {
+    listBenchmarkArgs* args = (listBenchmarkArgs*) arg;
+    unsigned long long state = args->seed;
+
+    args->hits = 0;
+    for (long i = 0; i < args->operations; i++) {
+        int value = (int) randomIndex(&state, BENCHMARK_CONCURRENT_KEYS);
+        long choice = randomIndex(&state, 200);
+        if (choice < 2 * args->searchPercent) {
+            args->hits += concurrentSearch(args->list, value);
+        }
+        else if (choice & 1) {
+            args->hits += concurrentInsert(args->list, value);
+        }
+        else {
+            args->hits += concurrentDelete(args->list, value);
+        }
+    }
+    concurrentListThreadExit();
+
+    return NULL;
+}
+
+static void* lockedListWorker(void* arg) {
+    listBenchmarkArgs* args = (listBenchmarkArgs*) arg;
+    unsigned long long state = args->seed;
+
+    args->hits = 0;
+    for (long i = 0; i < args->operations; i++) {
+        int value = (int) randomIndex(&state, BENCHMARK_CONCURRENT_KEYS);
+        long choice = randomIndex(&state, 200);
+        if (choice < 2 * args->searchPercent) {
+            args->hits += lockedListSearch(value);
+        }
+        else if (choice & 1) {
+            args->hits += lockedListInsert(value);
+        }
+        else {
+            args->hits += lockedListDelete(value);
+        }
+    }
+
+    return NULL;
+}
+
+/* Run 'worker' on 'numThreads' threads, return million operations per second. */
+static double runListWorkers(void* (*worker)(void*), int numThreads, int searchPercent) {
+    struct timespec start, end;
+    pthread_t threads[MAX_BENCHMARK_THREADS];
+    listBenchmarkArgs args[MAX_BENCHMARK_THREADS];
+
+    // both lists start with every other value
+    ConcurrentList* list = createConcurrentList();
+    for (long value = BENCHMARK_CONCURRENT_KEYS - 2; value >= 0; value -= 2) {
+        concurrentInsert(list, (int) value);
+        lockedListInsert((int) value);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int t = 0; t < numThreads; t++) {
+        args[t].list = list;
+        args[t].searchPercent = searchPercent;
+        args[t].operations = BENCHMARK_CONCURRENT_OPERATIONS / numThreads;
+        args[t].seed = (unsigned long long) t + 1;
+        pthread_create(&threads[t], NULL, worker, &args[t]);
+    }
+    long operations = 0;
+    for (int t = 0; t < numThreads; t++) {
+        pthread_join(threads[t], NULL);
+        operations += args[t].operations;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    freeConcurrentList(list);
+    while (lockedListHead != NULL) {
+        Node* next = lockedListHead->next;
+        free(lockedListHead);
+        lockedListHead = next;
+    }
+
+    return operations / elapsedSeconds(start, end) / 1e6;
+}
+
+/* Run concurrent list benchmark. */
+void benchmarkConcurrentList(void) {
+    int searchPercents[] = {90, 50};
+
+    printf("\n%ld operations on %ld keys shared between threads, Mops/s (lock-free / rwlock)\n",
+           BENCHMARK_CONCURRENT_OPERATIONS, BENCHMARK_CONCURRENT_KEYS);
+    for (int mix = 0; mix < 2; mix++) {
+        int searchPercent = searchPercents[mix];
+        printf("  %d%% search, %d%% insert/delete\n", searchPercent, 100 - searchPercent);
+        for (int numThreads = 1; numThreads <= MAX_BENCHMARK_THREADS; numThreads *= 2) {
+            double lockFree = runListWorkers(concurrentListWorker, numThreads, searchPercent);
+            double locked = runListWorkers(lockedListWorker, numThreads, searchPercent);
+            printf("    %2d threads %8.3f / %8.3f\n", numThreads, lockFree, locked);
+        }
+    }
+
+    // the main thread filled the lists
+    concurrentListThreadExit();
+}
+
+#endif
@@ -0,0 +1,341 @@
+/** @file   node_pool.h
+ *  @brief  Pool allocator for the fixed-size nodes of the stack, queue
+ *          and linked list. Nodes are carved out of large page-aligned
+ *          slabs instead of being allocated one by one, and every thread
+ *          keeps a small cache of free nodes that it refills from and
+ *          returns to the shared free list in batches.
+ *          A pool is meant to back one structure: all its nodes can then
+ *          be freed at once by releasing the slabs, which takes time
+ *          proportional to the number of slabs instead of nodes.
+ */
+
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <pthread.h>
+
+/* Bytes per slab, a multiple of the page size */
+#define POOL_PAGE_SIZE (4096)
+#define POOL_SLAB_SIZE (16 * POOL_PAGE_SIZE)
+
+/* Nodes moved between a thread cache and the shared free list at once */
+#define POOL_BATCH (64)
+
+/* Threads that can have a cache at the same time; any further threads
+   use the shared list until a thread with a cache exits */
+#define POOL_THREADS (64)
+
+/* Free node, linked through its first bytes. */
+struct poolFreeNode {
+    struct poolFreeNode* next;
+} typedef poolFreeNode;
+
+/* Free nodes cached by one thread, on its own cache line. */
+struct poolCache {
+    _Alignas(64) poolFreeNode* free;
+    int count;
+} typedef poolCache;
+
+/*
+    Struct to hold a node pool. Slabs are linked through their first
+    node-sized block; 'carve' and 'carveEnd' bound the part of the newest
+    slab that hasn't been handed out yet. Live pools are linked through
+    'nextPool' so that exiting threads can hand their caches back.
+    'users' counts the structures sharing the pool (see poolAttach()).
+*/
+struct nodePool {
+    size_t nodeSize;
+    struct nodePool* nextPool;
+    pthread_mutex_t lock;
+    void* slabs;
+    long slabCount;
+    long users;
+    char* carve;
+    char* carveEnd;
+    poolFreeNode* free;
+    poolCache caches[POOL_THREADS];
+} typedef NodePool;
+
+/* Cache slots, claimed by a thread on its first pool call and given
+   back when it exits (see poolThreadExit()) */
+static atomic_int poolSlotsInUse[POOL_THREADS];
+static _Thread_local int poolThreadIndex = -1;
+static pthread_key_t poolThreadKey;
+static pthread_once_t poolKeyOnce = PTHREAD_ONCE_INIT;
+
+/* Live pools, whose caches are flushed when a thread exits */
+static pthread_mutex_t poolRegistryLock = PTHREAD_MUTEX_INITIALIZER;
+static struct nodePool* poolRegistry = NULL;
+
+/* Called when a thread with a cache slot exits: move its cached nodes
+   of every pool to the pool's shared list and give the slot back. */
+static inline void poolThreadExit(void* slot) {
+    int index = (int) (intptr_t) slot - 1;
+
+    pthread_mutex_lock(&poolRegistryLock);
+    for (struct nodePool* pool = poolRegistry; pool != NULL; pool = pool->nextPool) {
+        poolCache* cache = &pool->caches[index];
+        if (cache->free == NULL) {
+            continue;
+        }
+
+        poolFreeNode* last = cache->free;
+        while (last->next != NULL) {
+            last = last->next;
+        }
+        pthread_mutex_lock(&pool->lock);
+        last->next = pool->free;
+        pool->free = cache->free;
+        pthread_mutex_unlock(&pool->lock);
+
+        cache->free = NULL;
+        cache->count = 0;
+    }
+    pthread_mutex_unlock(&poolRegistryLock);
+
+    atomic_store(&poolSlotsInUse[index], 0);
+}
+
+static inline void poolCreateKey(void) {
+    pthread_key_create(&poolThreadKey, poolThreadExit);
+}
+
+/* Index of the calling thread's cache, -1 if all are taken (tried again
+   on the next call). */
+static inline int poolCacheIndex(void) {
+    if (poolThreadIndex < 0) {
+        pthread_once(&poolKeyOnce, poolCreateKey);
+        for (int i = 0; i < POOL_THREADS; i++) {
+            int expected = 0;
+            if (atomic_load_explicit(&poolSlotsInUse[i], memory_order_relaxed) == 0 &&
+                atomic_compare_exchange_strong(&poolSlotsInUse[i], &expected, 1)) {
+                // the key's value is what poolThreadExit() gets, 0 means no slot
+                pthread_setspecific(poolThreadKey, (void*) (intptr_t) (i + 1));
+                poolThreadIndex = i;
+                break;
+            }
+        }
+    }
+    return poolThreadIndex;
+}
+
+/*
+    Allocate a pool for nodes of 'nodeSize' bytes. No memory for nodes
+    is allocated until the first node is.
+*/
+static inline NodePool* createNodePool(size_t nodeSize) {
+    NodePool* pool = (NodePool*) aligned_alloc(64, sizeof(NodePool));
+    assert(pool);
+
+    // round up so every node can hold a free list link and stays aligned
+    if (nodeSize < sizeof(poolFreeNode)) {
+        nodeSize = sizeof(poolFreeNode);
+    }
+    pool->nodeSize = (nodeSize + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1);
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pool->slabs = NULL;
+    pool->slabCount = 0;
+    pool->users = 0;
+    pool->carve = NULL;
+    pool->carveEnd = NULL;
+    pool->free = NULL;
+    for (int i = 0; i < POOL_THREADS; i++) {
+        pool->caches[i].free = NULL;
+        pool->caches[i].count = 0;
+    }
+
+    pthread_mutex_lock(&poolRegistryLock);
+    pool->nextPool = poolRegistry;
+    poolRegistry = pool;
+    pthread_mutex_unlock(&poolRegistryLock);
+
+    return pool;
+}
+
+/* Take up to POOL_BATCH nodes for a thread cache, with the lock held. */
+static inline poolFreeNode* poolTakeBatch(NodePool* pool, int* count) {
+    poolFreeNode* batch = NULL;
+    *count = 0;
+
+    // reuse freed nodes first
+    while (pool->free != NULL && *count < POOL_BATCH) {
+        poolFreeNode* node = pool->free;
+        pool->free = node->next;
+        node->next = batch;
+        batch = node;
+        (*count)++;
+    }
+    if (*count > 0) {
+        return batch;
+    }
+
+    // then carve new ones, starting a new slab when the current one is used up
+    if (pool->carve == pool->carveEnd) {
+        char* slab = (char*) aligned_alloc(POOL_PAGE_SIZE, POOL_SLAB_SIZE);
+        assert(slab);
+        *(void**) slab = pool->slabs;
+        pool->slabs = slab;
+        pool->slabCount++;
+        pool->carve = slab + pool->nodeSize;
+        pool->carveEnd = slab + (POOL_SLAB_SIZE / pool->nodeSize) * pool->nodeSize;
+    }
+    while (pool->carve != pool->carveEnd && *count < POOL_BATCH) {
+        poolFreeNode* node = (poolFreeNode*) pool->carve;
+        pool->carve += pool->nodeSize;
+        node->next = batch;
+        batch = node;
+        (*count)++;
+    }
+
+    return batch;
+}
+
+/*
+    Allocate a node from the pool.
+*/
+static inline void* poolAlloc(NodePool* pool) {
+    int index = poolCacheIndex();
+    poolFreeNode* node;
+
+    if (index < 0) {
+        int count;
+        pthread_mutex_lock(&pool->lock);
+        node = poolTakeBatch(pool, &count);
+        // keep only one node, the rest go back to the shared list
+        poolFreeNode* rest = node->next;
+        while (rest != NULL) {
+            poolFreeNode* next = rest->next;
+            rest->next = pool->free;
+            pool->free = rest;
+            rest = next;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        return node;
+    }
+
+    poolCache* cache = &pool->caches[index];
+    if (cache->free == NULL) {
+        pthread_mutex_lock(&pool->lock);
+        cache->free = poolTakeBatch(pool, &cache->count);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    node = cache->free;
+    cache->free = node->next;
+    cache->count--;
+
+    return node;
+}
+
+/*
+    Give a node allocated from the pool back to it.
+*/
+static inline void poolFree(NodePool* pool, void* pointer) {
+    int index = poolCacheIndex();
+    poolFreeNode* node = (poolFreeNode*) pointer;
+
+    if (index < 0) {
+        pthread_mutex_lock(&pool->lock);
+        node->next = pool->free;
+        pool->free = node;
+        pthread_mutex_unlock(&pool->lock);
+        return;
+    }
+
+    poolCache* cache = &pool->caches[index];
+    node->next = cache->free;
+    cache->free = node;
+    cache->count++;
+
+    // return a batch once the cache holds two, so alternating allocations
+    // and frees at the limit don't move a batch every time
+    if (cache->count >= 2 * POOL_BATCH) {
+        poolFreeNode* last = cache->free;
+        for (int i = 1; i < POOL_BATCH; i++) {
+            last = last->next;
+        }
+        poolFreeNode* batch = cache->free;
+        cache->free = last->next;
+        cache->count -= POOL_BATCH;
+
+        pthread_mutex_lock(&pool->lock);
+        last->next = pool->free;
+        pool->free = batch;
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/*
+    Register a structure that allocates from the pool, for structures
+    that can share a pool with others of their kind.
+*/
+static inline void poolAttach(NodePool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->users++;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+    Unregister a structure when it is freed. Returns 1 if it was the
+    last one using the pool, which can then release all slabs at once;
+    otherwise it has to give its nodes back one by one.
+*/
+static inline int poolDetach(NodePool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    int last = (--pool->users == 0);
+    pthread_mutex_unlock(&pool->lock);
+    return last;
+}
+
+/*
+    Free all nodes of the pool at once by freeing its slabs. The pool
+    stays usable. No other thread may use the pool while this runs.
+*/
+static inline void releaseNodePool(NodePool* pool) {
+    // keeps threads that exit meanwhile from flushing into freed slabs
+    pthread_mutex_lock(&poolRegistryLock);
+
+    void* slab = pool->slabs;
+    while (slab != NULL) {
+        void* next = *(void**) slab;
+        free(slab);
+        slab = next;
+    }
+
+    pool->slabs = NULL;
+    pool->slabCount = 0;
+    pool->carve = NULL;
+    pool->carveEnd = NULL;
+    pool->free = NULL;
+    for (int i = 0; i < POOL_THREADS; i++) {
+        pool->caches[i].free = NULL;
+        pool->caches[i].count = 0;
+    }
+
+    pthread_mutex_unlock(&poolRegistryLock);
+}
+
+/*
+    Free up the pool and all nodes allocated from it.
+*/
+static inline void freeNodePool(NodePool* pool) {
+    pthread_mutex_lock(&poolRegistryLock);
+    struct nodePool** link = &poolRegistry;
+    while (*link != pool) {
+        link = &(*link)->nextPool;
+    }
+    *link = pool->nextPool;
+    pthread_mutex_unlock(&poolRegistryLock);
+
+    releaseNodePool(pool);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+#endif
@@ -1,6 +1,8 @@
 /** @file   queue.c
  *  @brief  An implementation of a queue of integers in C. The data
  *          structure follows the FIFO (First In First Out) principle. 
+ *          Nodes can come from a node pool (see node_pool.h) instead of
+ *          malloc(), see createQueueWithPool().
  *  @author Mustafa Siddiqui
  *  @date   01/13/2020
  */
@@ -9,15 +11,19 @@
 #include <stdlib.h>
 #include <assert.h>
 
+#include "node_pool.h"
+
 struct queueNode {
     int value;
     struct queueNode* next;
 } typedef Node;
 
-/* Struct to hold head and tail nodes for queue. */
+/* Struct to hold head and tail nodes for queue, and the pool its nodes
+   come from (NULL to use malloc()). */
 struct queue {
     Node* head;
     Node* tail;
+    NodePool* pool;
 } typedef Queue;
 
 /*
@@ -33,6 +39,13 @@ __________________________________________________________________
 */
 Queue* createQueue(void);
 
+/*
+    Allocate memory for a queue whose nodes are allocated from 'pool'.
+    The pool must not be used for anything else since freeQueue()
+    releases all of its nodes at once.
+*/
+Queue* createQueueWithPool(NodePool* pool);
+
 /*
     Perform enqueue operation. Pushes value to the end of the queue.
 */
@@ -90,6 +103,19 @@ int main(void) {
 
     // free up allocated memory
     freeQueue(queue);
+    free(queue);
+
+    // same thing with nodes from a pool
+    NodePool* pool = createNodePool(sizeof(Node));
+    queue = createQueueWithPool(pool);
+    for (int i = 0; i < 10; i++) {
+        enqueue(queue, (i + 1));
+    }
+    dequeue(queue);
+    printQueue(queue);
+    freeQueue(queue);
+    free(queue);
+    freeNodePool(pool);
 
     return 0;
 }
@@ -110,6 +136,15 @@ Queue* createQueue(void) {
     // intialize to NULL to denote empty queue
     queue->head = NULL;
     queue->tail = NULL;
+    queue->pool = NULL;
+
+    return queue;
+}
+
+/* Create queue with nodes from pool. */
+Queue* createQueueWithPool(NodePool* pool) {
+    Queue* queue = createQueue();
+    queue->pool = pool;
 
     return queue;
 }
@@ -117,7 +152,7 @@ Queue* createQueue(void) {
 /* Push element to queue. */
 void enqueue(Queue* queue, int value) {
     // create new node to be inserted at tail
-    Node* newNode = (Node*) malloc(sizeof(Node));
+    Node* newNode = (queue->pool != NULL) ? (Node*) poolAlloc(queue->pool) : (Node*) malloc(sizeof(Node));
     assert(newNode);
 
     newNode->value = value;
@@ -154,7 +189,12 @@ int dequeue(Queue* queue) {
     queue->head = queue->head->next;
 
     // free memory allocated for deleted element
-    free(temp);
+    if (queue->pool != NULL) {
+        poolFree(queue->pool, temp);
+    }
+    else {
+        free(temp);
+    }
 
     return value;
 }
@@ -198,6 +238,14 @@ void printQueue(Queue* queue) {
 
 /* Free up allocated memory. */
 void freeQueue(Queue* queue) {
+    // all nodes of a pool can be freed at once
+    if (queue->pool != NULL) {
+        releaseNodePool(queue->pool);
+        queue->head = NULL;
+        queue->tail = NULL;
+        return;
+    }
+
     Node* currentNode = queue->head;
 
     // iterate over queue freeing nodes as we go using dequeue()
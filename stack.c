@@ -1,18 +1,126 @@
 /** @file   stack.c
  *  @brief  An implementation of a stack of integers in C. The data
  *          structure follows the LIFO (Last In First Out) principle. 
+ *          Also contains a chunked stack that stores values in large
+ *          arrays instead of one allocated node per value, and a
+ *          lock-free stack that can be shared between threads (with an
+ *          optional elimination array for heavy contention).
+ *          The pooled stack is the linked stack with its nodes taken
+ *          from a node pool (see node_pool.h) instead of malloc().
+ *          Compile with -DBENCHMARK to run the benchmarks.
  *  @author Mustafa Siddiqui
  *  @date   01/13/2020
  */
 
+#define _POSIX_C_SOURCE 200809L     // clock_gettime()
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sched.h>                  // sched_yield()
+
+#include "node_pool.h"
+
+#ifdef BENCHMARK
+#include <time.h>                   // clock_gettime()
+#include <pthread.h>
+#endif
+
+/* Number of values per chunk of a chunked stack */
+#define CHUNK_SIZE (1024)
 
 struct stackNode {
     int value;
     struct stackNode* next;
 } typedef Node;
 
+/* Fixed-size array of values, linked to the chunk below it. */
+struct stackChunk {
+    int values[CHUNK_SIZE];
+    struct stackChunk* next;
+} typedef Chunk;
+
+/*
+    Struct to hold a chunked stack. Values are pushed into the array of
+    the top chunk; a new chunk is only needed every CHUNK_SIZE pushes.
+    The last chunk that was emptied is kept as 'spare' so that pushing
+    and popping across a chunk boundary doesn't allocate and free a
+    chunk every time.
+*/
+struct chunkedStack {
+    Chunk* top;
+    int topCount;
+    Chunk* spare;
+    long size;
+} typedef ChunkedStack;
+
+/*
+    Struct to hold a linked stack whose nodes are allocated from 'pool'.
+    The pool is kept with the stack so that every push and pop uses it.
+*/
+struct pooledStack {
+    Node* top;
+    NodePool* pool;
+} typedef PooledStack;
+
+/* Size of a cache line, used to keep shared variables apart */
+#define CACHE_LINE_SIZE (64)
+
+/* Most threads that can use concurrent stacks at the same time */
+#define MAX_HAZARD_THREADS (128)
+
+/* Removed nodes a thread collects before trying to free them */
+#define RETIRE_THRESHOLD (2 * MAX_HAZARD_THREADS)
+
+/*
+    The top of a concurrent stack is a node pointer packed together with
+    a counter that changes on every push/pop: the pointer uses the low
+    48 bits (all that user space addresses use on x86-64 and AArch64)
+    and the counter the high 16 bits. A CAS on the top then also fails
+    if the same node was popped and pushed again in the meantime (the
+    ABA problem), e.g. when nodes are recycled.
+*/
+#define TAG_SHIFT (48)
+#define POINTER_MASK ((UINT64_C(1) << TAG_SHIFT) - 1)
+
+/* Slots in the elimination array of a concurrent stack */
+#define ELIMINATION_SLOTS (16)
+
+/* Times a thread checks its elimination slot before giving up */
+#define ELIMINATION_SPINS (128)
+
+/*
+    Slot of the elimination array where a push and a pop that both failed
+    to update the top can meet and hand over the value directly. The
+    high 32 bits hold the state, the low 32 bits the offered value.
+*/
+#define SLOT_EMPTY (UINT64_C(0))
+#define SLOT_OFFER (UINT64_C(1) << 32)
+#define SLOT_TAKEN (UINT64_C(2) << 32)
+#define SLOT_STATE_MASK (~UINT64_C(0) << 32)
+
+struct eliminationSlot {
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t exchange;
+} typedef eliminationSlot;
+
+/*
+    Struct to hold a lock-free (Treiber) stack that any number of threads
+    can push to and pop from. Popped nodes are not freed straight away
+    but retired and freed once no thread can still be reading them
+    (hazard pointers, see popConcurrent()).
+    With 'useElimination' set, a push or pop whose CAS on the top fails
+    tries to pair up with an opposite operation in the elimination array
+    before retrying, so a burst of pushes and pops doesn't all go
+    through the one cache line holding the top.
+*/
+struct concurrentStack {
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t top;
+    _Alignas(CACHE_LINE_SIZE) int useElimination;
+    eliminationSlot slots[ELIMINATION_SLOTS];
+} typedef ConcurrentStack;
+
 /*
 __________________________________________________________________
 
@@ -51,6 +159,122 @@ void printStack(Node* top);
 */
 void freeStack(Node* top);
 
+/*
+    Allocate memory for a stack whose nodes are allocated from 'pool'
+    and initialize it to empty. The pool must not be used for anything
+    else since freePooledStack() releases all of it.
+*/
+PooledStack* createPooledStack(NodePool* pool);
+
+/*
+    Add a value to the top of the pooled stack.
+*/
+void pooledPush(PooledStack* stack, int value);
+
+/*
+    Delete the value at the top of the pooled stack and store it in
+    'value'. Returns 1 if a value was popped and 0 if the stack is empty.
+*/
+int pooledPop(PooledStack* stack, int* value);
+
+/*
+    Free up the pooled stack. Its nodes are freed at once by releasing
+    the pool's slabs; the pool itself stays usable.
+*/
+void freePooledStack(PooledStack* stack);
+
+/*
+    Allocate memory for a chunked stack and initialize it to empty.
+*/
+ChunkedStack* createChunkedStack(void);
+
+/*
+    Add a value to the top of the chunked stack.
+*/
+void chunkedPush(ChunkedStack* stack, int value);
+
+/*
+    Delete the value at the top of the chunked stack and store it in
+    'value'. Returns 1 if a value was popped and 0 if the stack is empty.
+*/
+int chunkedPop(ChunkedStack* stack, int* value);
+
+/*
+    Search a value in the chunked stack.
+    Returns the position/index of the value (0 being the top) if value
+    is present in the stack and '-1' if value searched is not in stack.
+*/
+long chunkedSearch(ChunkedStack* stack, int valueToSearch);
+
+/*
+    Print all elements in the chunked stack.
+*/
+void printChunkedStack(ChunkedStack* stack);
+
+/*
+    Free up allocated memory for the chunked stack and its chunks.
+*/
+void freeChunkedStack(ChunkedStack* stack);
+
+/*
+    Allocate memory for a concurrent stack and initialize it to empty.
+    Pass 1 as 'useElimination' to put an elimination array in front of
+    the stack (worth it when many threads push and pop at once).
+*/
+ConcurrentStack* createConcurrentStack(int useElimination);
+
+/*
+    Add a value to the top of the concurrent stack. Safe to call from
+    any number of threads.
+*/
+void pushConcurrent(ConcurrentStack* stack, int value);
+
+/*
+    Delete the value at the top of the concurrent stack and store it in
+    'value'. Safe to call from any number of threads.
+    Returns 1 if a value was popped and 0 if the stack is empty.
+*/
+int popConcurrent(ConcurrentStack* stack, int* value);
+
+/*
+    Number of CAS operations on a stack top that failed (and had to be
+    retried) in the calling thread so far.
+*/
+unsigned long concurrentCasFailures(void);
+
+/*
+    Number of pushes and pops of the calling thread so far that were
+    completed through the elimination array instead of the stack top.
+*/
+unsigned long concurrentEliminations(void);
+
+/*
+    Must be called by every thread that used a concurrent stack before
+    it exits. Frees the nodes it popped (waiting for other threads to
+    stop reading them if needed) and gives up its hazard pointer.
+*/
+void concurrentThreadExit(void);
+
+/*
+    Free up allocated memory for the concurrent stack and its nodes. No
+    thread may use the stack after this is called.
+*/
+void freeConcurrentStack(ConcurrentStack* stack);
+
+#ifdef BENCHMARK
+/*
+    Push/pop throughput of the linked and the chunked stack.
+*/
+void benchmarkStacks(void);
+
+/*
+    Multi-thread push/pop throughput and CAS failure rate of the
+    concurrent stack compared with the linked stack behind a mutex, and
+    with and without elimination under a burst of random pushes and pops.
+*/
+void benchmarkConcurrentStack(void);
+#endif
+
 /*
 __________________________________________________________________
 
@@ -82,6 +306,50 @@ int main(void) {
     // free up allocated memory
     freeStack(top);
 
+    // same thing with nodes from a pool
+    int value;
+    NodePool* pool = createNodePool(sizeof(Node));
+    PooledStack* pooled = createPooledStack(pool);
+    for (int i = 0; i < 10; i++) {
+        pooledPush(pooled, (i + 1));
+    }
+    pooledPop(pooled, &value);
+    printStack(pooled->top);
+    freePooledStack(pooled);
+    freeNodePool(pool);
+
+    // same thing with the chunked stack
+    ChunkedStack* stack = createChunkedStack();
+    for (int i = 0; i < 10; i++) {
+        chunkedPush(stack, (i + 1));
+    }
+    printChunkedStack(stack);
+
+    for (int j = 0; j < 5; j++) {
+        chunkedPop(stack, &value);
+    }
+    printChunkedStack(stack);
+    printf("'%d' at position %ld.\n", num, chunkedSearch(stack, num));
+
+    freeChunkedStack(stack);
+
+    // and with the concurrent stack (from a single thread here)
+    ConcurrentStack* shared = createConcurrentStack(1);
+    for (int i = 0; i < 10; i++) {
+        pushConcurrent(shared, (i + 1));
+    }
+    while (popConcurrent(shared, &value)) {
+        printf("%d ", value);
+    }
+    printf("\n");
+    freeConcurrentStack(shared);
+    concurrentThreadExit();
+
+    #ifdef BENCHMARK
+        benchmarkStacks();
+        benchmarkConcurrentStack();
+    #endif
+
     return 0;
 }
 
@@ -160,3 +428,706 @@ void freeStack(Node* top) {
         free(previousNode);
     }
 }
+
+/* Create pooled stack. */
+PooledStack* createPooledStack(NodePool* pool) {
+    PooledStack* stack = (PooledStack*) malloc(sizeof(PooledStack));
+    assert(stack);
+    stack->top = NULL;
+    stack->pool = pool;
+
+    return stack;
+}
+
+/* Push node from pool to top of pooled stack. */
+void pooledPush(PooledStack* stack, int value) {
+    Node* newNode = (Node*) poolAlloc(stack->pool);
+    newNode->value = value;
+    newNode->next = stack->top;
+    stack->top = newNode;
+}
+
+/* Delete node from top of pooled stack, back to pool. */
+int pooledPop(PooledStack* stack, int* value) {
+    Node* top = stack->top;
+    if (top == NULL) {
+        return 0;
+    }
+
+    *value = top->value;
+    stack->top = top->next;
+    poolFree(stack->pool, top);
+
+    return 1;
+}
+
+/* Free up memory allocated for pooled stack. */
+void freePooledStack(PooledStack* stack) {
+    // all nodes of a pool can be freed at once
+    releaseNodePool(stack->pool);
+    free(stack);
+}
+
+/* Create chunked stack. */
+ChunkedStack* createChunkedStack(void) {
+    ChunkedStack* stack = (ChunkedStack*) malloc(sizeof(ChunkedStack));
+    assert(stack);
+
+    stack->top = NULL;
+    stack->topCount = 0;
+    stack->spare = NULL;
+    stack->size = 0;
+
+    return stack;
+}
+
+/* Push value to chunked stack. */
+void chunkedPush(ChunkedStack* stack, int value) {
+    // start a new chunk if the top one is full (or there is none)
+    if (stack->top == NULL || stack->topCount == CHUNK_SIZE) {
+        Chunk* chunk = stack->spare;
+        if (chunk != NULL) {
+            stack->spare = NULL;
+        }
+        else {
+            chunk = (Chunk*) malloc(sizeof(Chunk));
+            assert(chunk);
+        }
+
+        chunk->next = stack->top;
+        stack->top = chunk;
+        stack->topCount = 0;
+    }
+
+    stack->top->values[stack->topCount++] = value;
+    stack->size++;
+}
+
+/* Pop value from chunked stack. */
+int chunkedPop(ChunkedStack* stack, int* value) {
+    if (stack->size == 0) {
+        return 0;
+    }
+
+    *value = stack->top->values[--stack->topCount];
+    stack->size--;
+
+    // move on to the chunk below once the top one is empty, keeping the
+    // empty chunk as the spare (freeing any older spare)
+    if (stack->topCount == 0) {
+        Chunk* empty = stack->top;
+        stack->top = empty->next;
+        stack->topCount = (stack->top != NULL) ? CHUNK_SIZE : 0;
+
+        free(stack->spare);
+        stack->spare = empty;
+    }
+
+    return 1;
+}
+
+/* Search value in chunked stack. */
+long chunkedSearch(ChunkedStack* stack, int valueToSearch) {
+    long index = 0;
+    int count = stack->topCount;
+
+    // scan each chunk from its top value down, chunk by chunk
+    for (Chunk* chunk = stack->top; chunk != NULL; chunk = chunk->next) {
+        for (int i = count - 1; i >= 0; i--) {
+            if (chunk->values[i] == valueToSearch) {
+                return index + (count - 1 - i);
+            }
+        }
+        index += count;
+        count = CHUNK_SIZE;
+    }
+
+    // value not found, return -1
+    return -1;
+}
+
+/* Print elements stored in chunked stack. */
+void printChunkedStack(ChunkedStack* stack) {
+    int count = stack->topCount;
+    for (Chunk* chunk = stack->top; chunk != NULL; chunk = chunk->next) {
+        for (int i = count - 1; i >= 0; i--) {
+            printf("%d ", chunk->values[i]);
+        }
+        count = CHUNK_SIZE;
+    }
+    printf("\n");
+}
+
+/* Free up memory allocated for chunked stack. */
+void freeChunkedStack(ChunkedStack* stack) {
+    Chunk* currentChunk = stack->top;
+    Chunk* previousChunk = NULL;
+
+    // iterate through chunks and free them as we go
+    while (currentChunk != NULL) {
+        previousChunk = currentChunk;
+        currentChunk = currentChunk->next;
+
+        free(previousChunk);
+    }
+
+    free(stack->spare);
+    free(stack);
+}
+
+/*
+    Hazard pointers: before a thread reads a node that another thread
+    could pop and free at the same time, it publishes the node's address
+    in its own slot. A popped node is only freed once it isn't in any
+    slot. Each thread claims a slot the first time it pops.
+*/
+struct hazardSlot {
+    _Alignas(CACHE_LINE_SIZE) _Atomic(Node*) pointer;
+    atomic_int inUse;
+} typedef hazardSlot;
+
+static hazardSlot hazardSlots[MAX_HAZARD_THREADS];
+
+/* Per thread: hazard slot, popped nodes waiting to be freed and stats */
+static _Thread_local hazardSlot* threadSlot = NULL;
+static _Thread_local Node* retiredNodes[RETIRE_THRESHOLD];
+static _Thread_local int retiredCount = 0;
+static _Thread_local unsigned long casFailures = 0;
+
+/* Per thread: elimination window (slots in use) and random state */
+static _Thread_local int eliminationWindow = ELIMINATION_SLOTS;
+static _Thread_local uint32_t eliminationRandom = 0;
+static _Thread_local unsigned long eliminations = 0;
+
+/* Node of an eliminated push, reused by the next push */
+static _Thread_local Node* spareNode = NULL;
+
+/* Pack pointer and counter into a stack top. */
+static inline uint64_t packTop(Node* node, uint64_t tag) {
+    assert(((uintptr_t) node & ~POINTER_MASK) == 0);
+    return (uint64_t) (uintptr_t) node | (tag << TAG_SHIFT);
+}
+
+/* Node pointer of a stack top. */
+static inline Node* topNode(uint64_t top) {
+    return (Node*) (uintptr_t) (top & POINTER_MASK);
+}
+
+/* Counter of a stack top, plus one (wraps around after 2^16). */
+static inline uint64_t nextTag(uint64_t top) {
+    return (top >> TAG_SHIFT) + 1;
+}
+
+/* Claim a hazard slot for this thread. */
+static hazardSlot* getHazardSlot(void) {
+    if (threadSlot == NULL) {
+        for (int i = 0; i < MAX_HAZARD_THREADS; i++) {
+            int expected = 0;
+            if (atomic_compare_exchange_strong(&hazardSlots[i].inUse, &expected, 1)) {
+                threadSlot = &hazardSlots[i];
+                break;
+            }
+        }
+        assert(threadSlot);
+    }
+    return threadSlot;
+}
+
+/* Free retired nodes that are not in any hazard slot. */
+static void scanRetiredNodes(void) {
+    int kept = 0;
+    for (int i = 0; i < retiredCount; i++) {
+        Node* node = retiredNodes[i];
+
+        int isHazard = 0;
+        for (int j = 0; j < MAX_HAZARD_THREADS && !isHazard; j++) {
+            isHazard = (atomic_load(&hazardSlots[j].pointer) == node);
+        }
+
+        if (isHazard) {
+            retiredNodes[kept++] = node;
+        }
+        else {
+            free(node);
+        }
+    }
+    retiredCount = kept;
+}
+
+/* Free node once no thread can be reading it. */
+static void retireNode(Node* node) {
+    retiredNodes[retiredCount++] = node;
+    if (retiredCount == RETIRE_THRESHOLD) {
+        scanRetiredNodes();
+    }
+}
+
+/* Random elimination slot within the current window. */
+static eliminationSlot* pickSlot(ConcurrentStack* stack) {
+    // xorshift, seeded from the address of the thread-local state,
+    // which differs per thread
+    if (eliminationRandom == 0) {
+        eliminationRandom = (uint32_t) (uintptr_t) &eliminationRandom | 1;
+    }
+    eliminationRandom ^= eliminationRandom << 13;
+    eliminationRandom ^= eliminationRandom >> 17;
+    eliminationRandom ^= eliminationRandom << 5;
+
+    return &stack->slots[eliminationRandom % eliminationWindow];
+}
+
+/* Narrow window when nobody showed up, widen it when slots were busy. */
+static void shrinkWindow(void) {
+    if (eliminationWindow > 1) {
+        eliminationWindow /= 2;
+    }
+}
+
+static void growWindow(void) {
+    if (eliminationWindow < ELIMINATION_SLOTS) {
+        eliminationWindow *= 2;
+    }
+}
+
+/* Offer value to a pop in the elimination array. */
+static int eliminatePush(ConcurrentStack* stack, int value) {
+    eliminationSlot* slot = pickSlot(stack);
+    uint64_t offer = SLOT_OFFER | (uint32_t) value;
+
+    uint64_t expected = SLOT_EMPTY;
+    if (!atomic_compare_exchange_strong(&slot->exchange, &expected, offer)) {
+        growWindow();
+        return 0;
+    }
+
+    for (int i = 0; i < ELIMINATION_SPINS; i++) {
+        if (atomic_load_explicit(&slot->exchange, memory_order_acquire) == SLOT_TAKEN) {
+            atomic_store_explicit(&slot->exchange, SLOT_EMPTY, memory_order_release);
+            return 1;
+        }
+    }
+
+    // withdraw offer; if that fails a pop took it just now
+    if (atomic_compare_exchange_strong(&slot->exchange, &offer, SLOT_EMPTY)) {
+        shrinkWindow();
+        return 0;
+    }
+    atomic_store_explicit(&slot->exchange, SLOT_EMPTY, memory_order_release);
+    return 1;
+}
+
+/* Take value offered by a push in the elimination array. */
+static int eliminatePop(ConcurrentStack* stack, int* value) {
+    eliminationSlot* slot = pickSlot(stack);
+
+    for (int i = 0; i < ELIMINATION_SPINS; i++) {
+        uint64_t offer = atomic_load_explicit(&slot->exchange, memory_order_acquire);
+        if ((offer & SLOT_STATE_MASK) == SLOT_OFFER) {
+            if (atomic_compare_exchange_strong(&slot->exchange, &offer, SLOT_TAKEN)) {
+                *value = (int) (uint32_t) offer;
+                return 1;
+            }
+            growWindow();
+            return 0;
+        }
+    }
+
+    shrinkWindow();
+    return 0;
+}
+
+/* Create concurrent stack. */
+ConcurrentStack* createConcurrentStack(int useElimination) {
+    ConcurrentStack* stack = (ConcurrentStack*) aligned_alloc(CACHE_LINE_SIZE, sizeof(ConcurrentStack));
+    assert(stack);
+    atomic_init(&stack->top, packTop(NULL, 0));
+    stack->useElimination = useElimination;
+    for (int i = 0; i < ELIMINATION_SLOTS; i++) {
+        atomic_init(&stack->slots[i].exchange, SLOT_EMPTY);
+    }
+
+    return stack;
+}
+
+/* Push value to concurrent stack. */
+void pushConcurrent(ConcurrentStack* stack, int value) {
+    Node* newNode = spareNode;
+    if (newNode != NULL) {
+        spareNode = NULL;
+    }
+    else {
+        newNode = (Node*) malloc(sizeof(Node));
+        assert(newNode);
+    }
+    newNode->value = value;
+
+    // link node to current top and swap it in, retrying if another
+    // thread changed the top in the meantime ('top' is reloaded by the
+    // failed CAS)
+    uint64_t top = atomic_load_explicit(&stack->top, memory_order_relaxed);
+    while (1) {
+        newNode->next = topNode(top);
+        if (atomic_compare_exchange_weak_explicit(&stack->top, &top, packTop(newNode, nextTag(top)),
+                                                  memory_order_release, memory_order_relaxed)) {
+            break;
+        }
+        casFailures++;
+
+        if (stack->useElimination && eliminatePush(stack, value)) {
+            eliminations++;
+            spareNode = newNode;
+            break;
+        }
+        top = atomic_load_explicit(&stack->top, memory_order_relaxed);
+    }
+}
+
+/* Pop value from concurrent stack. */
+int popConcurrent(ConcurrentStack* stack, int* value) {
+    hazardSlot* slot = getHazardSlot();
+    uint64_t top;
+    Node* node;
+
+    while (1) {
+        top = atomic_load_explicit(&stack->top, memory_order_acquire);
+        node = topNode(top);
+        if (node == NULL) {
+            return 0;
+        }
+
+        // protect node, then check it is still the top; if it is, no
+        // thread can have freed it before it was protected
+        atomic_store(&slot->pointer, node);
+        if (atomic_load(&stack->top) != top) {
+            continue;
+        }
+
+        Node* next = node->next;
+        if (atomic_compare_exchange_weak_explicit(&stack->top, &top, packTop(next, nextTag(top)),
+                                                  memory_order_acquire, memory_order_relaxed)) {
+            break;
+        }
+        casFailures++;
+
+        if (stack->useElimination && eliminatePop(stack, value)) {
+            eliminations++;
+            atomic_store_explicit(&slot->pointer, NULL, memory_order_release);
+            return 1;
+        }
+    }
+
+    *value = node->value;
+    atomic_store_explicit(&slot->pointer, NULL, memory_order_release);
+    retireNode(node);
+
+    return 1;
+}
+
+/* CAS failures of calling thread. */
+unsigned long concurrentCasFailures(void) {
+    return casFailures;
+}
+
+/* Eliminated operations of calling thread. */
+unsigned long concurrentEliminations(void) {
+    return eliminations;
+}
+
+/* Clean up calling thread. */
+void concurrentThreadExit(void) {
+    // nodes still protected by other threads are only read briefly
+    while (retiredCount > 0) {
+        scanRetiredNodes();
+        if (retiredCount > 0) {
+            sched_yield();
+        }
+    }
+
+    free(spareNode);
+    spareNode = NULL;
+
+    if (threadSlot != NULL) {
+        atomic_store(&threadSlot->pointer, NULL);
+        atomic_store(&threadSlot->inUse, 0);
+        threadSlot = NULL;
+    }
+}
+
+/* Free up memory allocated for concurrent stack. */
+void freeConcurrentStack(ConcurrentStack* stack) {
+    freeStack(topNode(atomic_load(&stack->top)));
+    free(stack);
+}
+
+/*
+__________________________________________________________________
+
+                            BENCHMARKS
+__________________________________________________________________
+
+*/
+
+#ifdef BENCHMARK
+
+#ifndef BENCHMARK_OPERATIONS
+#define BENCHMARK_OPERATIONS (100000000L)
+#endif
+
+/* Depth the stack is filled to before emptying it again */
+#ifndef BENCHMARK_DEPTH
+#define BENCHMARK_DEPTH (1000000L)
+#endif
+
+/* Seconds between two timestamps. */
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/* Stops the compiler from optimizing a push()/pop() pair (and so its
+   malloc()/free() pair) away. */
+static Node* volatile escapedNode;
+
+/* Run stack benchmarks. */
+void benchmarkStacks(void) {
+    struct timespec start, end;
+    long rounds = BENCHMARK_OPERATIONS / (2 * BENCHMARK_DEPTH);
+    long long check = 0;
+    int value;
+
+    printf("\n%ld push/pop operations (fill to %ld, then empty)\n",
+           2 * rounds * BENCHMARK_DEPTH, BENCHMARK_DEPTH);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    Node* top = NULL;
+    for (long r = 0; r < rounds; r++) {
+        for (long i = 0; i < BENCHMARK_DEPTH; i++) {
+            top = push(top, (int) i);
+        }
+        for (long i = 0; i < BENCHMARK_DEPTH; i++) {
+            check += top->value;
+            top = pop(top);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  linked  %6.2f ns/op\n", elapsedSeconds(start, end) / (2.0 * rounds * BENCHMARK_DEPTH) * 1e9);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    NodePool* pool = createNodePool(sizeof(Node));
+    PooledStack* pooled = createPooledStack(pool);
+    for (long r = 0; r < rounds; r++) {
+        for (long i = 0; i < BENCHMARK_DEPTH; i++) {
+            pooledPush(pooled, (int) i);
+        }
+        for (long i = 0; i < BENCHMARK_DEPTH; i++) {
+            pooledPop(pooled, &value);
+            check += value;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  pooled  %6.2f ns/op\n", elapsedSeconds(start, end) / (2.0 * rounds * BENCHMARK_DEPTH) * 1e9);
+
+    // fill once more and free the whole stack at once
+    for (long i = 0; i < BENCHMARK_DEPTH; i++) {
+        pooledPush(pooled, (int) i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    freePooledStack(pooled);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  free %ld nodes: pooled %.2f ms", BENCHMARK_DEPTH, elapsedSeconds(start, end) * 1e3);
+
+    for (long i = 0; i < BENCHMARK_DEPTH; i++) {
+        top = push(top, (int) i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    freeStack(top);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf(", linked %.2f ms\n", elapsedSeconds(start, end) * 1e3);
+    freeNodePool(pool);
+    top = NULL;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ChunkedStack* stack = createChunkedStack();
+    for (long r = 0; r < rounds; r++) {
+        for (long i = 0; i < BENCHMARK_DEPTH; i++) {
+            chunkedPush(stack, (int) i);
+        }
+        for (long i = 0; i < BENCHMARK_DEPTH; i++) {
+            chunkedPop(stack, &value);
+            check -= value;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  chunked %6.2f ns/op\n", elapsedSeconds(start, end) / (2.0 * rounds * BENCHMARK_DEPTH) * 1e9);
+
+    // push and pop alternately right at a chunk boundary
+    printf("%ld push/pop operations at a chunk boundary\n", BENCHMARK_OPERATIONS);
+    for (int i = 0; i < CHUNK_SIZE; i++) {
+        chunkedPush(stack, i);
+    }
+    top = push(NULL, 0);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < BENCHMARK_OPERATIONS / 2; i++) {
+        top = push(top, (int) i);
+        escapedNode = top;
+        check += top->value;
+        top = pop(top);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  linked  %6.2f ns/op\n", elapsedSeconds(start, end) / BENCHMARK_OPERATIONS * 1e9);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < BENCHMARK_OPERATIONS / 2; i++) {
+        chunkedPush(stack, (int) i);
+        chunkedPop(stack, &value);
+        check -= value;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  chunked %6.2f ns/op (check %lld)\n",
+           elapsedSeconds(start, end) / BENCHMARK_OPERATIONS * 1e9, check);
+
+    freeStack(top);
+    freeChunkedStack(stack);
+}
+
+#ifndef BENCHMARK_CONCURRENT_OPERATIONS
+#define BENCHMARK_CONCURRENT_OPERATIONS (20000000L)
+#endif
+
+#define MAX_BENCHMARK_THREADS (16)
+
+/* Linked stack behind a mutex, what sharing it takes without the
+   concurrent stack. */
+static pthread_mutex_t lockedStackMutex = PTHREAD_MUTEX_INITIALIZER;
+static Node* lockedStackTop = NULL;
+
+/* Arguments and results of a benchmark thread. */
+struct stackBenchmarkArgs {
+    ConcurrentStack* stack;
+    long pairs;
+    long long sum;
+    unsigned long failures;
+    unsigned long eliminations;
+} typedef stackBenchmarkArgs;
+
+/* Each thread pushes and pops alternately. */
+static void* concurrentWorker(void* arg) {
+    stackBenchmarkArgs* args = (stackBenchmarkArgs*) arg;
+    int value;
+
+    args->sum = 0;
+    for (long i = 0; i < args->pairs; i++) {
+        pushConcurrent(args->stack, (int) i);
+        if (popConcurrent(args->stack, &value)) {
+            args->sum += value;
+        }
+    }
+    args->failures = concurrentCasFailures();
+    args->eliminations = concurrentEliminations();
+    concurrentThreadExit();
+
+    return NULL;
+}
+
+/* Each thread pushes or pops at random, as under a burst of requests
+   (push and pop each count as one of a pair here). */
+static void* burstWorker(void* arg) {
+    stackBenchmarkArgs* args = (stackBenchmarkArgs*) arg;
+    uint32_t random = (uint32_t) (uintptr_t) arg | 1;
+    int value;
+
+    args->sum = 0;
+    for (long i = 0; i < 2 * args->pairs; i++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        if (random & 1) {
+            pushConcurrent(args->stack, 1);
+        }
+        else if (popConcurrent(args->stack, &value)) {
+            args->sum += value;
+        }
+    }
+    args->failures = concurrentCasFailures();
+    args->eliminations = concurrentEliminations();
+    concurrentThreadExit();
+
+    return NULL;
+}
+
+static void* lockedWorker(void* arg) {
+    stackBenchmarkArgs* args = (stackBenchmarkArgs*) arg;
+
+    args->sum = 0;
+    for (long i = 0; i < args->pairs; i++) {
+        pthread_mutex_lock(&lockedStackMutex);
+        lockedStackTop = push(lockedStackTop, (int) i);
+        pthread_mutex_unlock(&lockedStackMutex);
+
+        pthread_mutex_lock(&lockedStackMutex);
+        if (lockedStackTop != NULL) {
+            args->sum += lockedStackTop->value;
+            lockedStackTop = pop(lockedStackTop);
+        }
+        pthread_mutex_unlock(&lockedStackMutex);
+    }
+    args->failures = 0;
+    args->eliminations = 0;
+
+    return NULL;
+}
+
+/* Run 'worker' on 'numThreads' threads and print throughput. */
+static void runStackWorkers(const char* name, void* (*worker)(void*), int numThreads,
+                            int useElimination) {
+    struct timespec start, end;
+    pthread_t threads[MAX_BENCHMARK_THREADS];
+    stackBenchmarkArgs args[MAX_BENCHMARK_THREADS];
+    ConcurrentStack* stack = createConcurrentStack(useElimination);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int t = 0; t < numThreads; t++) {
+        args[t].stack = stack;
+        args[t].pairs = BENCHMARK_CONCURRENT_OPERATIONS / 2 / numThreads;
+        pthread_create(&threads[t], NULL, worker, &args[t]);
+    }
+    long long sum = 0;
+    unsigned long failures = 0;
+    unsigned long eliminated = 0;
+    long operations = 0;
+    for (int t = 0; t < numThreads; t++) {
+        pthread_join(threads[t], NULL);
+        sum += args[t].sum;
+        failures += args[t].failures;
+        eliminated += args[t].eliminations;
+        operations += 2 * args[t].pairs;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    printf("  %-11s %2d threads: %7.2f Mops/s, %5.2f%% CAS failures, "
+           "%5.2f%% eliminated (check %lld)\n",
+           name, numThreads, operations / elapsedSeconds(start, end) / 1e6,
+           100.0 * failures / operations, 100.0 * eliminated / operations, sum);
+
+    freeConcurrentStack(stack);
+}
+
+/* Run concurrent stack benchmarks. */
+void benchmarkConcurrentStack(void) {
+    printf("\n%ld push/pop operations shared between threads\n", BENCHMARK_CONCURRENT_OPERATIONS);
+
+    for (int numThreads = 1; numThreads <= MAX_BENCHMARK_THREADS; numThreads *= 2) {
+        runStackWorkers("treiber", concurrentWorker, numThreads, 0);
+        runStackWorkers("mutex", lockedWorker, numThreads, 0);
+    }
+
+    printf("\nBurst of random pushes and pops\n");
+    for (int numThreads = 1; numThreads <= MAX_BENCHMARK_THREADS; numThreads *= 2) {
+        runStackWorkers("treiber", burstWorker, numThreads, 0);
+        runStackWorkers("elimination", burstWorker, numThreads, 1);
+    }
+
+    freeStack(lockedStackTop);
+}
+
+#endif